@@ -0,0 +1,165 @@
+; =============================================================================
+; 16-BIT MBR CHAINLOADER (STAGE0)
+;
+; Installed in sector 0 of a partitioned hard disk image. This loader:
+;   1. Sets up the CPU segments and stack.
+;   2. Moves itself from 0000:7C00 down to 0000:0600 to make room.
+;   3. Finds the active (0x80) entry in the partition table.
+;   4. Reads that partition's first sector (its VBR, i.e. stage1) to
+;      0000:7C00, with INT 13h extensions when available, CHS otherwise.
+;   5. Jumps to it with DL = boot drive and DS:SI -> the partition entry,
+;      as a BIOS-loaded MBR would.
+;   6. On error, prints a one-letter error code and waits for a keypress,
+;      then reboots.
+;
+; Only the first 446 bytes of the assembled sector are installed; the
+; partition table and signature come from the image's own MBR.
+;
+; Assemble with: nasm -f bin mbr.asm -o stage0.bin
+; =============================================================================
+
+org 0x0600             ; Where we run after relocating ourselves.
+bits 16
+
+MBR_LOAD_ADDRESS        equ 0x7C00      ; Where the BIOS loaded us
+MBR_RUN_ADDRESS         equ 0x0600      ; Where we move to
+VBR_LOAD_ADDRESS        equ 0x7C00      ; Where the VBR expects to be
+VBR_SIGNATURE           equ VBR_LOAD_ADDRESS + 510
+
+PARTITION_ENTRY_SIZE    equ 16
+PARTITION_ACTIVE        equ 0x80
+
+start:
+    ; -------------------------------------------------------------------------
+    ; 1) Segments and stack (stack grows down from our load address).
+    ; -------------------------------------------------------------------------
+    cli
+    xor ax, ax
+    mov ds, ax
+    mov es, ax
+    mov ss, ax
+    mov sp, MBR_LOAD_ADDRESS
+    sti
+
+    ; -------------------------------------------------------------------------
+    ; 2) Relocate to 0000:0600, so the VBR can be loaded where we are now,
+    ;    and continue there with a far jump.
+    ; -------------------------------------------------------------------------
+    cld
+    mov si, MBR_LOAD_ADDRESS
+    mov di, MBR_RUN_ADDRESS
+    mov cx, 256                 ; 512 bytes
+    rep movsw
+    jmp 0:relocated
+
+relocated:
+    mov [boot_drive], dl
+
+    ; -------------------------------------------------------------------------
+    ; 3) Find the active partition.
+    ; -------------------------------------------------------------------------
+    mov si, partition_table
+    mov cx, 4
+.find_active:
+    cmp byte [si], PARTITION_ACTIVE
+    je .found_active
+    add si, PARTITION_ENTRY_SIZE
+    loop .find_active
+
+    mov al, 'P'                 ; No active partition
+    jmp error
+
+.found_active:
+    ; -------------------------------------------------------------------------
+    ; 4) Read the VBR. SI keeps pointing at the partition entry.
+    ;    Entry layout: +1 head, +2 sector/cylinder (CHS of the first
+    ;    sector, as INT 13h AH=02h wants them in DH/CX), +8 LBA.
+    ; -------------------------------------------------------------------------
+    mov ah, 41h                 ; INT 13h extensions present?
+    mov bx, 55AAh
+    mov dl, [boot_drive]
+    int 13h
+    jc .read_vbr
+    cmp bx, 0AA55h
+    jne .read_vbr
+    test cl, 1                  ; Packet (AH=42h) access supported?
+    jz .read_vbr
+    mov byte [read_function], 42h
+
+.read_vbr:
+    mov eax, [si + 8]
+    mov [dap_lba], eax
+
+    mov bp, 3                   ; Retry count
+.retry:
+    push si
+    mov ah, [read_function]
+    mov al, 1                   ; AL = 1 sector (CHS path)
+    mov bx, VBR_LOAD_ADDRESS    ; ES:BX = destination (CHS path)
+    mov dh, [si + 1]            ; DH = head
+    mov cx, [si + 2]            ; CX = sector / cylinder
+    mov dl, [boot_drive]
+    mov si, dap                 ; DS:SI = packet (AH=42h path)
+    mov word [dap_count], 1     ; A failed AH=42h call rewrites the count
+    stc                         ; Some BIOSes need CF set
+    int 13h
+    pop si
+    jnc .loaded
+
+    xor ax, ax                  ; Reset disk controller (AH=0) and try again
+    int 13h
+    dec bp
+    jnz .retry
+
+    mov al, 'D'                 ; Reading the VBR failed
+    jmp error
+
+.loaded:
+    cmp word [VBR_SIGNATURE], 0AA55h
+    mov al, 'V'                 ; Not a boot sector
+    jne error
+
+    ; -------------------------------------------------------------------------
+    ; 5) Hand over to the VBR.
+    ; -------------------------------------------------------------------------
+    mov dl, [boot_drive]
+    jmp 0:VBR_LOAD_ADDRESS
+
+; =============================================================================
+; Error Handler
+;   P = no active partition in the partition table
+;   D = reading the VBR failed after all retries
+;   V = the VBR has no 0xAA55 signature
+; =============================================================================
+error:
+    mov ah, 0x0E        ; BIOS teletype function
+    xor bx, bx          ; Page number
+    int 0x10            ; Print AL
+
+    mov ah, 0
+    int 16h             ; Wait for keystroke
+    int 19h             ; Reboot
+
+; =============================================================================
+; Variables
+; =============================================================================
+boot_drive:             db 0
+
+; INT 13h function used for the VBR read: 02h (CHS) or 42h (extended).
+read_function:          db 02h
+
+; Disk Address Packet for AH=42h.
+dap:                    db 10h          ; Packet size
+                        db 0
+dap_count:              dw 1            ; Sector count (blocks actually read on return)
+                        dw VBR_LOAD_ADDRESS, 0 ; Buffer (offset, segment)
+dap_lba:                dd 0            ; LBA bits 0..31
+                        dd 0            ; LBA bits 32..63
+
+; =============================================================================
+; Partition table (filled in by the image tools) and boot signature
+; =============================================================================
+times 446-($-$$) db 0
+partition_table:
+times 64 db 0
+dw 0AA55h
@@ -1,5 +1,5 @@
 ; =============================================================================
-; 16-BIT FAT12 BOOTLOADER FOR A 1.44MB FLOPPY DISK
+; 16-BIT FAT12 BOOTLOADER (1.44MB FLOPPY LAYOUT BY DEFAULT)
 ;
 ; This bootloader:
 ;   1. Sets up the CPU segments and stack.
@@ -7,7 +7,18 @@
 ;   3. Locates the FAT12 root directory and finds "KERNEL.BIN".
 ;   4. Reads the kernel file from the FAT12 filesystem by following the FAT chain.
 ;   5. Jumps to the loaded kernel (at segment 0x2000).
-;   6. On error, prints a message and waits for a keypress, then reboots.
+;   6. On error, prints a one-letter error code and waits for a keypress,
+;      then reboots.
+;
+; Assembled with -DSTAGE2_IN_RESERVED, steps 3 and 4 are replaced by a
+; single read: stage2 is expected in the FAT reserved sectors right after
+; the boot sector (LBA 1 .. bdb_reserved_sectors-1), so neither the root
+; directory nor the FAT is touched. 'make STAGE2_LAYOUT=reserved' builds
+; a matching image.
+;
+; Assembled with -DSTAGE1_TRACK_CACHE (the floppy image's stage1), disk_read
+; always reads whole tracks into a track buffer and serves later requests
+; for the same track from it; the INT 13h extensions path is left out.
 ;
 ; Assemble with: nasm -f bin boot.asm -o boot.bin
 ; Then write boot.bin to your floppy image or disk.
@@ -16,8 +27,6 @@
 org 0x7C00             ; Boot sector is loaded by BIOS at 0000:7C00 (or 07C0:0000).
 bits 16                ; 16-bit real mode code.
 
-%define ENDL 0x0D, 0x0A  ; Macro for DOS/BIOS newline: CR LF
-
 ; =============================================================================
 ; FAT12 HEADER (BIOS PARAMETER BLOCK + EXTENDED BOOT RECORD)
 ; =============================================================================
@@ -49,6 +58,56 @@ ebr_volume_id:              db 12h, 34h, 56h, 78h   ; Volume serial number
 ebr_volume_label:           db 'DuckyOS    '        ; 11-byte volume label (pad with spaces)
 ebr_system_id:              db 'FAT12   '           ; 8-byte system ID string
 
+; =============================================================================
+; STAGE1 -> STAGE2 HANDOFF BLOCK (fixed at 0000:7C3E, right after the EBPB)
+;
+; Together with the BPB above, which stage1 patches with the geometry the
+; BIOS reports, this tells stage2 everything stage1 learned about the boot
+; disk, so stage2 does not have to probe or re-read any of it:
+;   - geometry and drive number: bdb_sectors_per_track, bdb_heads,
+;     ebr_drive_number
+;   - partition offset:          bdb_hidden_sectors
+;   - INT 13h extensions:        disk_read_function = 42h
+;   - cached metadata:           root directory sector root_cached_lba at
+;                                'buffer' (0000:7E00), FAT sectors
+;                                fat_cached_sector and the one after it at
+;                                'fat_buffer' (0000:8000)
+; Keep in sync with src/bootloader/stage2/handoff.h.
+; =============================================================================
+HANDOFF_MAGIC               equ 'DH'
+HANDOFF_VERSION             equ 1
+
+handoff_magic:              dw HANDOFF_MAGIC
+handoff_version:            db HANDOFF_VERSION
+
+; INT 13h function used by disk_read: 02h (CHS read), or 42h (extended
+; read) once the extensions probe succeeds.
+disk_read_function:         db 02h
+
+; LBA of the first data sector (cluster 2), computed from the BPB.
+data_lba:                   dw 0
+
+; LBA of the root directory sector held in 'buffer' (0FFFFh = none).
+root_cached_lba:            dw 0FFFFh
+
+; FAT sector (relative to the first FAT) currently held in fat_buffer
+; (0FFFFh = none).
+fat_cached_sector:          dw 0FFFFh
+
+; =============================================================================
+; BOOT TIMELINE (fixed at 0000:0500, outside the boot sector)
+;
+; Stage1 stamps the low word of the BIOS tick counter at 0040:006C (the count
+; INT 1Ah AH=00h returns, 18.2 Hz) into the first words of this block; stage2
+; and the kernel add their own stamps after it and stage2 prints the result.
+; Keep in sync with src/bootloader/stage2/timeline.h.
+; =============================================================================
+BIOS_TICKS                  equ 046Ch
+BOOT_TIMELINE               equ 0500h
+TL_STAGE1_ENTRY             equ BOOT_TIMELINE + 0   ; Stage1 started
+TL_ROOT_READ                equ BOOT_TIMELINE + 2   ; STAGE2.BIN found
+TL_FAT_LOADED               equ BOOT_TIMELINE + 4   ; Last FAT sector read
+
 ; =============================================================================
 ; START OF BOOT CODE
 ; =============================================================================
@@ -57,7 +116,7 @@ start:
     ; -------------------------------------------------------------------------
     ; 1) Set up segment registers and the stack.
     ; -------------------------------------------------------------------------
-    mov ax, 0            ; We'll use segment 0 for DS and ES for now
+    xor ax, ax           ; We'll use segment 0 for DS and ES for now
     mov ds, ax
     mov es, ax
     
@@ -65,334 +124,527 @@ start:
     mov ss, ax           ; Set stack segment
     mov sp, 0x7C00       ; Place stack at 0x7C00 (downwards)
 
-    ; Some BIOSes set the boot segment to 07C0:0000 instead of 0000:7C00.
-    ; Force CS:IP = 0000:7C00 so our offsets match.
-    push es              ; ES = 0 from above
-    push word .after
-    retf
+    mov ax, [BIOS_TICKS]
+    mov [TL_STAGE1_ENTRY], ax
+%ifdef STAGE2_IN_RESERVED
+    mov [TL_ROOT_READ], ax      ; No root directory or FAT to read
+    mov [TL_FAT_LOADED], ax
+%endif
 
-.after:
+    ; Some BIOSes enter at 07C0:0000 instead of 0000:7C00. That is harmless:
+    ; every jump and call below is IP-relative and all data goes through
+    ; DS = 0, so CS is never used to address anything.
 
     ; -------------------------------------------------------------------------
-    ; 2) Save drive number (DL) and display a "Loading..." message.
+    ; 2) Save drive number (DL). Stage1 stays silent unless something fails;
+    ;    stage2 greets the user as soon as it runs.
     ; -------------------------------------------------------------------------
     mov [ebr_drive_number], dl  ; Store BIOS drive number to EBPB field
-    mov si, msg_loading
-    call puts                   ; Print "Loading..."
 
+%ifndef STAGE1_TRACK_CACHE
     ; -------------------------------------------------------------------------
-    ; 3) Read drive geometry from BIOS (INT 13h, AH=08h).
-    ;    - We only do this to get heads/sectors dynamically if needed.
+    ; 3) Probe for INT 13h extensions (AH=41h). When the drive supports the
+    ;    packet interface, disk_read uses AH=42h with plain LBAs instead of
+    ;    translating to CHS, which is what hard disks and USB media want.
+    ; -------------------------------------------------------------------------
+    mov ah, 41h
+    mov bx, 55AAh
+    int 13h
+    jc .no_extensions
+    cmp bx, 0AA55h             ; BX is swapped when extensions are installed
+    jne .no_extensions
+    shr cx, 1                  ; Bit 0: packet (AH=42h..44h) access supported
+    jnc .no_extensions
+    mov byte [disk_read_function], 42h
+.no_extensions:
+%endif
+
+    ; -------------------------------------------------------------------------
+    ;    Read drive geometry from BIOS (INT 13h, AH=08h).
+    ;    - We only do this to get heads/sectors dynamically if needed;
+    ;      if the BIOS can't tell us, the BPB values are kept.
     ; -------------------------------------------------------------------------
     push es
     mov ah, 08h               ; Get drive parameters
     int 13h
-    jc floppy_error            ; Jump if CF is set (error)
     pop es
+    jc .keep_bpb_geometry      ; Jump if CF is set (error)
 
-    and cl, 0x3F               ; Sector count is in CL (lower 6 bits)
-    xor ch, ch
+    and cx, 0x3F               ; Sector count is in CL (lower 6 bits)
     mov [bdb_sectors_per_track], cx  ; Store #sectors/track
     inc dh
     mov [bdb_heads], dh              ; Store #heads (1-based)
+.keep_bpb_geometry:
 
     ; -------------------------------------------------------------------------
     ; 4) Compute LBA of the root directory
     ;    LBA(root dir) = reserved_sectors + (fat_count * sectors_per_fat)
     ; -------------------------------------------------------------------------
-    mov ax, [bdb_sectors_per_fat]
-    mov bl, [bdb_fat_count]
-    xor bh, bh
-    mul bx                     ; AX = sectors_per_fat * fat_count
+    mov al, [bdb_fat_count]
+    cbw
+    mul word [bdb_sectors_per_fat] ; AX = sectors_per_fat * fat_count
     add ax, [bdb_reserved_sectors] ; AX = root directory start LBA
-    push ax                    ; Keep this on stack for later
 
-    ; -------------------------------------------------------------------------
-    ; 5) Compute # of sectors in the root directory:
-    ;    root_dir_size_sectors = (32 * dir_entries) / bytes_per_sector (round up)
-    ; -------------------------------------------------------------------------
-    mov ax, [bdb_dir_entries_count]
-    shl ax, 5         ; Multiply by 32 (size of one directory entry)
-    xor dx, dx
-    div word [bdb_bytes_per_sector]
-    test dx, dx
-    jz .root_dir_after
-    inc ax            ; If remainder != 0, we need one more sector
-.root_dir_after:
+    ; The data area (cluster 2) starts right after the root directory:
+    ;    LBA(data) = LBA(root dir) + (32 * dir_entries) / 512
+    ; mkfs.fat always sizes the root directory in whole sectors.
+    mov dx, [bdb_dir_entries_count]
+    mov cx, dx
+    shr cx, 4                      ; 16 directory entries per sector
+    add cx, ax
+    mov [data_lba], cx
 
+%ifdef STAGE2_IN_RESERVED
     ; -------------------------------------------------------------------------
-    ; 6) Read root directory into memory (in 'buffer').
+    ; 5) Stage2 fills the reserved sectors after the boot sector, so one
+    ;    contiguous read loads all of it to 0x2000:0x0000.
     ; -------------------------------------------------------------------------
-    mov cl, al        ; CL = # of sectors to read
-    pop ax            ; AX = root directory start LBA
-    mov dl, [ebr_drive_number] ; DL = drive
-    mov bx, buffer    ; ES:BX = destination
+    push KERNEL_LOAD_SEGMENT
+    pop es
+    xor bx, bx                      ; BX = KERNEL_LOAD_OFFSET
+    mov ax, 1                       ; LBA 1 = first sector after this one
+    mov cx, [bdb_reserved_sectors]
+    dec cx                          ; CX = stage2 sectors
+    jz stage2_not_found_error       ; No reserved sectors -> no stage2
     call disk_read
-
+%else
     ; -------------------------------------------------------------------------
-    ; 7) Search for "KERNEL.BIN" in the root directory.
+    ; 5) Read the root directory one sector at a time into 'buffer' and
+    ;    search each sector for "STAGE2.BIN" as soon as it arrives.
+    ;    The scan stops at the match or at the first free (0x00) entry,
+    ;    which marks the end of the directory, so on our images (stage2.bin
+    ;    is copied first) only one root directory sector is ever read.
+    ;    DX = directory entries left to examine.
     ; -------------------------------------------------------------------------
-    xor bx, bx
-    mov di, buffer
+    mov bx, buffer          ; ES:BX = destination
+
+.read_root_sector:
+    mov cx, 1
+    mov [root_cached_lba], ax
+    push es
+    call disk_read
+    pop es                  ; disk_read advanced ES, the search needs it back
+    inc ax                  ; AX = next root directory sector
+    mov di, bx
+
+.search_stage2:
+    cmp byte [di], 0        ; Free entry => no more entries follow
+    je stage2_not_found_error
 
-.search_kernel:
     mov si, file_stage2_bin
-    mov cx, 11              ; Compare up to 11 chars (DOS 8.3 filename)
+    mov cl, 11              ; Compare up to 11 chars (DOS 8.3 filename)
+                            ; (CH is already 0: CX is 1 or a leftover count)
     push di
     repe cmpsb              ; Compare string in [DI..] with [SI..]
     pop di
-    je .found_kernel        ; If match, jump
+    je .found_stage2        ; If match, jump
 
     add di, 32              ; Next directory entry (32 bytes each)
-    inc bx
-    cmp bx, [bdb_dir_entries_count]
-    jl .search_kernel
-
-    ; If we get here, we didn't find KERNEL.BIN
-    jmp kernel_not_found_error
+    dec dx
+    jz stage2_not_found_error
+    test dl, 0Fh
+    jnz .search_stage2      ; More entries in this sector (16 per sector)
+    jmp .read_root_sector
 
-.found_kernel:
-    ; DI points to the start of directory entry
-    ; Offset 26 in a directory entry is the first cluster (WORD).
-    mov ax, [di + 26]
-    mov [stage2_cluster], ax
-
-    ; -------------------------------------------------------------------------
-    ; 8) Load the entire FAT into 'buffer' so we can parse the cluster chain.
-    ; -------------------------------------------------------------------------
-    mov ax, [bdb_reserved_sectors]  ; LBA of the first FAT
-    mov bx, buffer
-    mov cl, [bdb_sectors_per_fat]   ; # of sectors to read
-    mov dl, [ebr_drive_number]
-    call disk_read
+.found_stage2:
+    mov ax, [BIOS_TICKS]
+    mov [TL_ROOT_READ], ax
 
     ; -------------------------------------------------------------------------
-    ; 9) Read the kernel, following the FAT cluster chain.
-    ;    We'll load the kernel to 0x2000:0x0000 in memory.
+    ; 6) Read stage2, following the FAT cluster chain. FAT sectors are
+    ;    loaded on demand by fat_next_cluster.
+    ;    We'll load it to 0x2000:0x0000 in memory. BX stays 0 and disk_read
+    ;    advances ES after every read, so a transfer never wraps the offset.
     ; -------------------------------------------------------------------------
-    mov bx, KERNEL_LOAD_SEGMENT
-    mov es, bx
-    mov bx, KERNEL_LOAD_OFFSET
-
-.load_kernel_loop:
-    mov ax, [stage2_cluster]
-
-    ; Hardcode LBA offset for cluster N:
-    ;   LBA =  (N-2)*sectors_per_cluster + (reserved + fats + rootdir)
-    ; Since sectors_per_cluster=1 for floppy, we do (N + constant).
-    ; For a standard 1.44M layout, the data area starts at sector 33,
-    ; so for cluster 2 => LBA=33. => offset = +31 from cluster number.
-    add ax, 31
-    mov cl, 1
-    mov dl, [ebr_drive_number]
-    call disk_read
+    push KERNEL_LOAD_SEGMENT
+    pop es
+    xor bx, bx                      ; BX = KERNEL_LOAD_OFFSET
 
-    ; Advance BX by 512 (bytes per sector) to read next sector in memory.
-    add bx, [bdb_bytes_per_sector]
+    ; DI points to the start of directory entry
+    ; Offset 26 in a directory entry is the first cluster (WORD).
+    mov ax, [di + 26]               ; AX = first cluster of STAGE2.BIN
 
+.load_stage2_loop:
     ; -------------------------------------------------------------------------
-    ; 10) Use the FAT (already in 'buffer') to find the next cluster.
-    ;     FAT12 has 12-bit entries, so each cluster can be at an even/odd nibble.
+    ; 7) Gather a run of physically consecutive clusters. We keep walking
+    ;     the chain while the next cluster is (previous + 1), so a file that
+    ;     mkfs/mcopy laid out contiguously is read with a single disk_read.
+    ;     DI = first cluster of the run, CX = length of the run.
     ; -------------------------------------------------------------------------
-    mov ax, [stage2_cluster]
-    mov cx, 3
-    mul cx            ; AX = cluster * 3
-    mov cx, 2
-    div cx            ; AX = offset in bytes, DX = cluster mod 2 ?
-
-    mov si, buffer
-    add si, ax
-    mov ax, [ds:si]   ; Read 2 bytes from the FAT
-
-    or dx, dx
-    jz .even
-.odd:
-    shr ax, 4         ; Odd cluster -> shift right 4 bits
-    jmp .next_cluster_after
-
-.even:
-    and ax, 0x0FFF    ; Even cluster -> lower 12 bits
-
-.next_cluster_after:
-    cmp ax, 0x0FF8    ; 0xFF8..0xFFF => end of chain
-    jae .read_finish
-
-    mov [stage2_cluster], ax
-    jmp .load_kernel_loop
+    mov di, ax
+    xor cx, cx
+
+.extend_run:
+    inc cx
+    mov si, ax
+    call fat_next_cluster   ; AX = cluster following AX
+    inc si
+    cmp ax, si
+    je .extend_run          ; Adjacent -> same run
+
+    ; LBA offset for cluster N:
+    ;   LBA =  (N-2)*sectors_per_cluster + (reserved + fats + rootdir)
+    ; and the run is CX * sectors_per_cluster sectors long.
+    push ax                 ; Save the cluster that follows this run
+    mov al, [bdb_sectors_per_cluster]
+    mov ah, 0
+    mov si, ax              ; SI = sectors per cluster
+    mul cx
+    xchg ax, cx             ; CX = sectors in the run
+    lea ax, [di - 2]
+    mul si
+    add ax, [data_lba]      ; AX = LBA of the first cluster in the run
+    call disk_read          ; Reads the run and advances ES past it
+    pop ax
+    cmp ax, 0x0FF8          ; 0xFF8..0xFFF => end of chain
+    jb .load_stage2_loop
+%endif
 
-.read_finish:
     ; -------------------------------------------------------------------------
-    ; 11) Jump to the loaded kernel at 0x2000:0x0000.
+    ; 8) Jump to the loaded stage2 at 0x2000:0x0000. Stage2 sets up its own
+    ;    segments and reads the drive number and everything else it needs
+    ;    from the BPB and the handoff block.
     ; -------------------------------------------------------------------------
-    mov dl, [ebr_drive_number]  ; Keep drive # in DL for the kernel's usage
-
-    mov ax, KERNEL_LOAD_SEGMENT
-    mov ds, ax
-    mov es, ax
-
     jmp KERNEL_LOAD_SEGMENT:KERNEL_LOAD_OFFSET
 
-    ; If for some reason we return here, just hang or reboot
-    jmp wait_key_and_reboot
-
-    cli
-    hlt
-
 ; =============================================================================
 ; Error Handlers
+; There is no room left in the sector for messages, so a failure prints a
+; single error code before waiting for a key:
+;   D = reading from disk failed after all retries
+;   F = STAGE2.BIN was not found in the root directory (or, with
+;       STAGE2_IN_RESERVED, the image has no reserved sectors for it)
 ; =============================================================================
 
-floppy_error:
-    mov si, msg_read_failed
-    call puts
-    jmp wait_key_and_reboot
+stage2_not_found_error:
+    mov al, 'F'
 
-kernel_not_found_error:
-    mov si, msg_stage2_not_found
-    call puts
-    jmp wait_key_and_reboot
+error:
+    mov ah, 0x0E        ; BIOS teletype function
+    xor bx, bx          ; Page number
+    int 0x10            ; Print AL
 
-; Wait for key press and then jump to the BIOS reboot vector FFFF:0000
+; Wait for key press and then hand control back to the BIOS bootstrap
+; loader (INT 19h), which retries the boot from scratch.
 wait_key_and_reboot:
     mov ah, 0
     int 16h             ; Wait for keystroke
-    jmp 0FFFFh:0        ; Jump to BIOS, causing reboot
-
-.halt:
-    cli
-    hlt
+    int 19h             ; Reboot
 
+%ifndef STAGE2_IN_RESERVED
 ; =============================================================================
-; Display String Routine (BIOS Teletype)
-; DS:SI -> Null-terminated string
+; FAT12 Routines
 ; =============================================================================
-puts:
-    push si
-    push ax
+
+; -------------------------------------------------------------------------
+; Look up the FAT entry of a cluster.
+; FAT12 packs two 12-bit entries into 3 bytes, so the entry for cluster N
+; is the word at byte offset N + N/2: low 12 bits if N is even, high 12
+; bits if N is odd.
+; Only the FAT sector holding that word is loaded, into 'fat_buffer',
+; together with the sector after it so that an entry straddling the
+; boundary is complete. The pair stays cached until a lookup lands in a
+; different sector, so a short chain costs a single read.
+; Input:
+;   AX = cluster
+; Output:
+;   AX = next cluster in the chain (>= 0xFF8 means end of chain)
+; -------------------------------------------------------------------------
+; Clobbers DX and BP.
+fat_next_cluster:
     push bx
+    push cx
 
-.loop:
-    lodsb               ; Load next char into AL from DS:SI
-    or al, al
-    jz .puts_done       ; If AL=0, end of string
+    mov bp, ax
+    shr bp, 1
+    sbb dx, dx                  ; DX = -1 if N is odd, 0 if even
+    add bp, ax                  ; BP = N * 3 / 2
+    mov ax, bp
+    shr ax, 9                   ; AX = FAT sector holding the entry
+    and bp, 1FFh                ; BP = offset inside that sector
 
-    mov ah, 0x0E        ; BIOS teletype function
-    mov bh, 0           ; Page number
-    int 0x10            ; Print AL
+    cmp ax, [fat_cached_sector]
+    je .cached
+    mov [fat_cached_sector], ax
+
+    push es
+    push ds
+    pop es                      ; fat_buffer lives in segment 0
+    add ax, [bdb_reserved_sectors]
+    mov bx, fat_buffer
+    mov cx, 2
+    call disk_read
+    mov ax, [BIOS_TICKS]
+    mov [TL_FAT_LOADED], ax
+    pop es
+
+.cached:
+    mov ax, [fat_buffer + bp]   ; SS = DS = 0
 
-    jmp .puts_loop
+    test dx, dx
+    jz .even
+    shr ax, 4                   ; Odd cluster -> high 12 bits
+.even:
+    and ah, 0x0F                ; Keep 12 bits
 
-.done:
+    pop cx
     pop bx
-    pop ax
-    pop si
     ret
+%endif
 
 ; =============================================================================
 ; Disk I/O Routines
 ; =============================================================================
 
+%ifndef STAGE1_TRACK_CACHE
+; A read failed: reset the controller and retry until disk_read's retry
+; count runs out, then fail with 'D'.
+; Kept out of disk_read's chunk loop so the loop stays within a short jump.
+disk_read_failed:
+    xor ax, ax            ; Reset disk controller (AH=0) and try again
+    int 13h
+    dec bp
+    jnz disk_read.retry
+%endif
+
+floppy_error:
+    mov al, 'D'
+    jmp error
+
+%ifndef STAGE1_TRACK_CACHE
 ; -------------------------------------------------------------------------
-; Convert LBA -> CHS for a floppy (or similarly structured disk).
-; Input:
-;   AX = LBA
-;   [bdb_sectors_per_track], [bdb_heads] used
-; Output:
-;   CH, CL, DH = geometry-based cylinder/head/sector
-;   (DL is restored after call)
+; Reads CX sectors from LBA=AX into ES:BX from the boot drive.
+; AX is relative to the start of our partition: bdb_hidden_sectors (the
+; partition's LBA, 0 on a floppy) is added here, so every read of stage1
+; lands inside the partition it was booted from. The sum is carried as 32
+; bits (DX:AX) into the packet, so with INT 13h extensions the partition
+; may start anywhere below 2 TiB; the CHS path reaches what CHS can address.
+; The request is split into chunks so that no single INT 13h call crosses
+; a 64 KiB physical boundary (the ISA DMA controller cannot wrap its
+; address) or, on the CHS path, a track (most floppy BIOSes refuse
+; multi-track reads). With INT 13h extensions a chunk is only limited by
+; the 64 KiB boundary and by 127 sectors per call, the most many EDD
+; BIOSes accept in one AH=42h packet (stage2's disk.c uses the same cap).
+; ES:BX must be sector aligned.
+; On return ES is advanced past the data read (BX is unchanged), so
+; consecutive calls fill memory back to back. Uses 3 retries on error.
 ; -------------------------------------------------------------------------
-lba_to_chs:
-    push ax
-    push dx
-
+disk_read:
+    pusha
     xor dx, dx
-    div word [bdb_sectors_per_track]   ; AX = LBA / SPT, DX = LBA % SPT
+    add ax, [bdb_hidden_sectors]       ; Partition-relative -> absolute LBA
+    adc dx, [bdb_hidden_sectors + 2]   ; DX:AX = absolute LBA
+
+.chunk:
+    push cx               ; Save # of sectors still to read
+
+    ; DI = sectors left before the next 64 KiB boundary, at most 127:
+    ; (0x10000 - (linear(ES:BX) & 0xFFFF)) / 512, where an aligned buffer
+    ; (128 sectors to go) wraps to 0 and is read as 0FFFFh / 512 = 127.
+    mov di, es
+    shl di, 4
+    add di, bx
+    neg di
+    jnz .not_aligned
+    dec di
+.not_aligned:
+    shr di, 9
+    cmp di, cx
+    jb .min_count
+    mov di, cx                         ; DI = sectors in this chunk
+.min_count:
+
+    ; Disk Address Packet for AH=42h, built on the stack (SS = DS = 0).
+    ; The CHS path ignores DS:SI; both paths unstack the packet in .done.
+    push dword 0          ; LBA bits 32..63
+    push dx               ; LBA bits 16..31
+    push ax               ; LBA bits 0..15
+    push es
+    push bx               ; Transfer buffer
+    push di               ; Block count
+    push byte 10h         ; Packet size
+    mov si, sp
+
+    cmp byte [disk_read_function], 42h
+    je .lba
+
+    ; Convert LBA -> CHS and clamp the chunk to the end of this track.
+    ; DX:AX / SPT needs LBA < 65536 * SPT (2 GiB at 63 SPT), far beyond
+    ; anything a BIOS without INT 13h extensions can reach anyway.
+    mov cx, [bdb_sectors_per_track]
+    div cx                             ; AX = LBA / SPT, DX = LBA % SPT
+    sub cx, dx                         ; CX = sectors left on this track
+    cmp di, cx
+    jb .min_track
+    mov di, cx
+.min_track:
     inc dx                             ; Sector is 1-based
-    mov cx, dx                         ; Save sector in CX (lower 6 bits)
-    
+    mov cl, dl                         ; CL = sector (lower 6 bits)
     xor dx, dx
-    div word [bdb_heads]              ; AX = cylinder, DX = head
+    div word [bdb_heads]               ; AX = cylinder, DX = head
     mov dh, dl                         ; DH = head
     mov ch, al                         ; CH = cylinder (low 8 bits)
     shl ah, 6
     or cl, ah                          ; Put top 2 bits of cylinder into CL
 
-    pop ax
-    mov dl, al                         ; Restore DL
-    pop ax
-    ret
+.lba:
+    mov dl, [ebr_drive_number]         ; DL = drive
+    mov bp, 3             ; Retry count
+
+.retry:
+    mov [si + 2], di      ; The BIOS rewrites the block count on failure
+    mov ax, di            ; AL = # of sectors
+    mov ah, [disk_read_function]
+    stc                   ; Some BIOSes need CF set
+    int 13h
+    jc disk_read_failed   ; Retries out of line, see above
 
+    ; The packet is exactly 8 words, so POPA drops it and hands back
+    ; SI = block count, BP = buffer offset, DX:BX = LBA bits 0..31 and
+    ; AX = LBA bits 48..63 = 0.
+    popa
+    pop cx
+    add bx, si
+    adc dx, 0
+    xchg ax, bx           ; Advance (absolute) LBA in DX:AX; BX = 0
+    mov bx, bp
+    imul di, si, 32       ; DI = paragraphs read (512 / 16 per sector)
+    mov bp, es
+    add bp, di
+    mov es, bp            ; Advance destination
+    sub cx, si            ; Fewer sectors to go
+    jnz .chunk
+
+    popa
+    ret
+%else
 ; -------------------------------------------------------------------------
-; Reads CL sectors from LBA=AX into ES:BX from drive DL.
-; Uses 3 retries on error.
+; Reads CX sectors from LBA=AX into ES:BX from the boot drive, through a
+; one-track cache.
+; AX is relative to the start of our partition, as for the other disk_read,
+; but the absolute LBA is kept in 16 bits: a floppy has no hidden sectors,
+; and a read that would land beyond LBA 65535 fails with 'D' instead.
+; A floppy read costs a full rotation whether it takes 1 sector or 18, so
+; every BIOS call here reads a whole track (sector 1 .. SPT of one
+; cylinder/head) into the track buffer, and requests are served by copying
+; out of it. Requests that fall on the cached track need no BIOS call at
+; all: the root directory, the FAT and the start of the data area share
+; cylinder 0, so a floppy boot takes 2-3 reads plus one per further track
+; of stage2.
+; The track buffer is 64 KiB aligned, so a read never crosses a DMA
+; boundary, and the destination ES:BX needs no alignment.
+; On return ES is advanced past the data read (BX is unchanged), so
+; consecutive calls fill memory back to back. Uses 3 retries on error.
 ; -------------------------------------------------------------------------
 disk_read:
-    push ax
-    push bx
-    push cx
-    push dx
-    push di
+    pusha
+    add ax, [bdb_hidden_sectors]       ; Partition-relative -> absolute LBA
+    jc floppy_error
+    cmp word [bdb_hidden_sectors + 2], 0
+    jne floppy_error                   ; Absolute LBA must fit in 16 bits
 
-    push cx               ; Save CL (# of sectors)
-    call lba_to_chs       ; Convert LBA -> CHS
-    pop ax                ; AX now has # of sectors to read in AL
+.chunk:
+    push cx               ; Save # of sectors still to read
+    push ax               ; Save LBA of this chunk
 
-    mov ah, 02h          ; BIOS: Read sectors (INT 13h)
-    mov di, 3             ; Retry count
+    ; Split the LBA into track and sector, and clamp the chunk to the end
+    ; of the track.
+    mov di, cx
+    mov cx, [bdb_sectors_per_track]
+    xor dx, dx
+    div cx                             ; AX = track, DX = sector in track
+    sub cx, dx                         ; CX = sectors left on this track
+    cmp di, cx
+    jb .min_track
+    mov di, cx                         ; DI = sectors in this chunk
+.min_track:
+    mov si, dx
+    shl si, 9                          ; SI = chunk's offset in the buffer
+
+    cmp ax, [cached_track]
+    je .copy
+    mov [cached_track], ax
+
+    ; Read the whole track into the track buffer.
+    push es
+    pusha
+    xor dx, dx
+    div word [bdb_heads]               ; AX = cylinder, DX = head
+    mov dh, dl                         ; DH = head
+    mov ch, al                         ; CH = cylinder (low 8 bits)
+    shl ah, 6
+    mov cl, 1                          ; From sector 1 ...
+    or cl, ah                          ; ... plus top 2 bits of cylinder
+    mov dl, [ebr_drive_number]         ; DL = drive
+    push TRACK_BUFFER_SEGMENT
+    pop es
+    xor bx, bx                         ; ES:BX = track buffer
+    mov bp, 3             ; Retry count
 
 .retry:
-    pusha
+    mov ax, [bdb_sectors_per_track]    ; AL = ... to the end of the track
+    mov ah, 02h
     stc                   ; Some BIOSes need CF set
     int 13h
-    jnc .done             ; If no carry, read succeeded
+    jnc .read_done        ; If no carry, read succeeded
 
-    popa
-    call disk_reset       ; Attempt to reset
-    dec di
-    test di, di
+    xor ax, ax            ; Reset disk controller (AH=0) and try again
+    int 13h
+    dec bp
     jnz .retry
 
-.fail:
     jmp floppy_error      ; All retries failed
 
-.done:
+.read_done:
     popa
+    pop es
 
-    pop di
-    pop dx
-    pop cx
-    pop bx
+.copy:
+    ; Copy DI sectors from the track buffer at SI to ES:BX.
+    mov bp, di            ; BP = sectors in this chunk
+    mov cx, di
+    shl cx, 8             ; 256 words per sector
+    mov di, bx
+    push ds
+    push TRACK_BUFFER_SEGMENT
+    pop ds
+    rep movsw
+    pop ds
+
+    mov dx, bp
+    shl dx, 5             ; DX = paragraphs copied (512 / 16 per sector)
+    mov cx, es
+    add cx, dx
+    mov es, cx            ; Advance destination
     pop ax
-    ret
+    add ax, bp            ; Advance LBA
+    pop cx
+    sub cx, bp            ; Fewer sectors to go
+    jnz .chunk
 
-; -------------------------------------------------------------------------
-; Reset disk drive controller (INT 13h, AH=0).
-; -------------------------------------------------------------------------
-disk_reset:
-    pusha
-    mov ah, 0
-    stc
-    int 13h
-    jc floppy_error
     popa
     ret
+%endif
 
 ; =============================================================================
-; Embedded Messages and Variables
+; Embedded Variables
 ; =============================================================================
 
-msg_loading:            db 'Loading...', ENDL, 0
-msg_read_failed:        db 'Read from disk failed!', ENDL, 0
-msg_kernel_not_found:   db 'STAGE2.BIN file not found!', ENDL, 0
-
+%ifndef STAGE2_IN_RESERVED
 ; DOS 8.3 filename (11 bytes: 8 for name + 3 for extension)
-; "KERNEL  BIN" has two spaces to align the extension in an 8.3 name.
-file_kernel_bin:        db 'STAGE2  BIN'
+; "STAGE2  BIN" has two spaces to align the extension in an 8.3 name.
+file_stage2_bin:        db 'STAGE2  BIN'
+%endif
+
+%ifdef STAGE1_TRACK_CACHE
+; Track held in the track buffer (LBA / sectors_per_track), 0FFFFh = none.
+cached_track:           dw 0FFFFh
 
-; Will store the first cluster of KERNEL.BIN
-kernel_cluster:         dw 0
+; Whole-track buffer (64 KiB aligned, up to 63 sectors; below stage2).
+TRACK_BUFFER_SEGMENT    equ 0x1000
+%endif
 
-; Define where to load the kernel (physical = 0x2000 * 16 = 0x20000)
+; Define where to load stage2 (physical = 0x2000 * 16 = 0x20000)
 KERNEL_LOAD_SEGMENT     equ 0x2000
 KERNEL_LOAD_OFFSET      equ 0
 
@@ -401,7 +653,8 @@ KERNEL_LOAD_OFFSET      equ 0
 times 510-($-$$) db 0
 dw 0AA55h
 
-buffer:
+buffer:                                 ; Root directory sector
+fat_buffer              equ buffer + 512 ; Two FAT sectors
 ; =============================================================================
 ; END OF BOOT SECTOR (512 BYTES)
 ; =============================================================================
@@ -0,0 +1,47 @@
+/******************************************************************************
+ *  DESCRIPTION:
+ *      Fixed-size ring buffer that keeps a copy of stage2's output in memory
+ *      (see bootlog.h). Logging is a memory copy, so it costs far less than
+ *      any device and can stay on when the screen is turned off.
+ ******************************************************************************/
+
+#include "bootlog.h"
+
+#define BOOTLOG_DATA_SIZE           (BOOTLOG_SIZE - (uint16_t)sizeof(BootLog) + 1)
+
+/******************************************************************************
+ * BootLog_Init
+ * ----------------------------------------------------------------------------
+ * Empties the log. Call it before the first write.
+ ******************************************************************************/
+void BootLog_Init()
+{
+    BootLog far* log = g_BootLog;
+
+    log->Magic = BOOTLOG_MAGIC;
+    log->DataSize = BOOTLOG_DATA_SIZE;
+    log->Head = 0;
+    log->Written = 0;
+}
+
+/******************************************************************************
+ * BootLog_Write
+ * ----------------------------------------------------------------------------
+ * Appends 'length' bytes, overwriting the oldest ones once the log is full.
+ ******************************************************************************/
+void BootLog_Write(const char* data, uint16_t length)
+{
+    BootLog far* log = g_BootLog;
+    uint16_t head = log->Head;
+    uint16_t i;
+
+    for (i = 0; i < length; i++)
+    {
+        log->Data[head++] = data[i];
+        if (head == BOOTLOG_DATA_SIZE)
+            head = 0;
+    }
+
+    log->Head = head;
+    log->Written += length;
+}
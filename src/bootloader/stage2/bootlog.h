@@ -0,0 +1,35 @@
+#pragma once
+#include "stdint.h"
+
+/******************************************************************************
+ * Boot log.
+ *
+ * A ring buffer at a fixed physical address that receives a copy of all
+ * stage2 output (see STDIO_OUTPUT_LOG). It outlives stage2: its address is
+ * published in BootInfo, and the kernel checks Magic and reports Written.
+ * Data[] holds the most recent DataSize bytes; if Written is larger than
+ * DataSize the log has wrapped and the oldest byte is at Head.
+ ******************************************************************************/
+
+#define BOOTLOG_SEGMENT             0x9000
+#define BOOTLOG_ADDRESS             0x00090000ul    /* Physical */
+#define BOOTLOG_SIZE                0x4000          /* Header included */
+#define BOOTLOG_MAGIC               0x474F4C42ul    /* 'BLOG' */
+
+#pragma pack(push, 1)
+
+typedef struct
+{
+    uint32_t Magic;                  // BOOTLOG_MAGIC once initialised
+    uint16_t DataSize;               // Capacity of Data[]
+    uint16_t Head;                   // Offset in Data[] of the next write
+    uint32_t Written;                // Total bytes ever logged
+    char     Data[1];                // DataSize bytes
+} BootLog;
+
+#pragma pack(pop)
+
+#define g_BootLog                   ((BootLog far*)((uint32_t)BOOTLOG_SEGMENT << 16))
+
+void BootLog_Init();
+void BootLog_Write(const char* data, uint16_t length);
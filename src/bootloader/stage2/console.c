@@ -0,0 +1,168 @@
+/******************************************************************************
+ *  DESCRIPTION:
+ *      Text console that writes character/attribute words straight into VGA
+ *      text memory at B800:0000, instead of one INT 10h call per character.
+ *
+ *      - The cursor position is kept in software; the CRTC hardware cursor
+ *        (and the BIOS's copy of the position, so later INT 10h users carry
+ *        on where we stopped) is only updated by Console_Flush().
+ *      - Scrolling is done by x86_Video_ScrollUp() with 32-bit string moves.
+ *      - Console_Write() copies runs of printable characters into a line in
+ *        one tight loop; stdio hands it whole buffers.
+ *      - Assumes the 80x25 colour text mode the BIOS leaves us in.
+ ******************************************************************************/
+
+#include "console.h"
+#include "x86.h"
+
+#define CONSOLE_WIDTH               80
+#define CONSOLE_HEIGHT              25
+#define CONSOLE_ATTRIBUTE           0x07        /* Light grey on black */
+#define CONSOLE_TAB_WIDTH           8
+
+#define VGA_TEXT_MEMORY             ((uint16_t far*)0xB8000000)
+
+#define CRTC_INDEX_PORT             0x3D4
+#define CRTC_DATA_PORT              0x3D5
+#define CRTC_CURSOR_LOCATION_HIGH   0x0E
+#define CRTC_CURSOR_LOCATION_LOW    0x0F
+
+/* BIOS data area 0040:0050: cursor column and row of video page 0. */
+#define BDA_CURSOR_POSITION         ((uint8_t far*)0x00400050)
+
+static uint8_t g_CursorX;
+static uint8_t g_CursorY;
+
+/******************************************************************************
+ * console_wrap
+ * ----------------------------------------------------------------------------
+ * Wraps the cursor at the right edge and scrolls at the bottom.
+ ******************************************************************************/
+static void console_wrap()
+{
+    if (g_CursorX >= CONSOLE_WIDTH)
+    {
+        g_CursorX = 0;
+        g_CursorY++;
+    }
+
+    if (g_CursorY >= CONSOLE_HEIGHT)
+    {
+        x86_Video_ScrollUp(CONSOLE_WIDTH, CONSOLE_HEIGHT, CONSOLE_ATTRIBUTE);
+        g_CursorY = CONSOLE_HEIGHT - 1;
+    }
+}
+
+/******************************************************************************
+ * Console_Init
+ * ----------------------------------------------------------------------------
+ * Picks up the cursor where the BIOS left it, so boot messages printed
+ * before stage2 stay on screen.
+ ******************************************************************************/
+void Console_Init()
+{
+    const uint8_t far* bdaCursor = BDA_CURSOR_POSITION;
+
+    g_CursorX = bdaCursor[0];
+    g_CursorY = bdaCursor[1];
+
+    if (g_CursorX >= CONSOLE_WIDTH)
+        g_CursorX = 0;
+    if (g_CursorY >= CONSOLE_HEIGHT)
+        g_CursorY = CONSOLE_HEIGHT - 1;
+}
+
+/******************************************************************************
+ * Console_PutChar
+ * ----------------------------------------------------------------------------
+ * Writes one character at the software cursor and advances it, with the
+ * same control characters as BIOS teletype output: '\r' returns to column
+ * 0, '\n' moves down a line (without returning), '\b' moves back. Tabs
+ * advance to the next multiple of CONSOLE_TAB_WIDTH.
+ ******************************************************************************/
+void Console_PutChar(char c)
+{
+    switch (c)
+    {
+        case '\r':
+            g_CursorX = 0;
+            break;
+
+        case '\n':
+            g_CursorY++;
+            break;
+
+        case '\b':
+            if (g_CursorX > 0)
+                g_CursorX--;
+            break;
+
+        case '\t':
+            g_CursorX = (g_CursorX + CONSOLE_TAB_WIDTH) & ~(CONSOLE_TAB_WIDTH - 1);
+            break;
+
+        default:
+            VGA_TEXT_MEMORY[g_CursorY * CONSOLE_WIDTH + g_CursorX] =
+                ((uint16_t)CONSOLE_ATTRIBUTE << 8) | (uint8_t)c;
+            g_CursorX++;
+            break;
+    }
+
+    console_wrap();
+}
+
+/******************************************************************************
+ * Console_Write
+ * ----------------------------------------------------------------------------
+ * Writes 'length' characters from 'str'. Runs of printable characters are
+ * stored straight into the current line; control characters go through
+ * Console_PutChar().
+ ******************************************************************************/
+void Console_Write(const char* str, uint16_t length)
+{
+    while (length > 0)
+    {
+        uint16_t far* cell;
+        uint16_t room;
+        uint16_t run;
+
+        if ((uint8_t)*str < ' ')
+        {
+            Console_PutChar(*str);
+            str++;
+            length--;
+            continue;
+        }
+
+        /* Copy up to the next control character or the end of the line. */
+        cell = &VGA_TEXT_MEMORY[g_CursorY * CONSOLE_WIDTH + g_CursorX];
+        room = CONSOLE_WIDTH - g_CursorX;
+        for (run = 0; run < length && run < room && (uint8_t)str[run] >= ' '; run++)
+            cell[run] = ((uint16_t)CONSOLE_ATTRIBUTE << 8) | (uint8_t)str[run];
+
+        g_CursorX += run;
+        str += run;
+        length -= run;
+        console_wrap();
+    }
+}
+
+/******************************************************************************
+ * Console_Flush
+ * ----------------------------------------------------------------------------
+ * Moves the hardware cursor to the software cursor and stores the position
+ * in the BIOS data area.
+ ******************************************************************************/
+void Console_Flush()
+{
+    uint8_t far* bdaCursor = BDA_CURSOR_POSITION;
+    uint16_t position = g_CursorY * CONSOLE_WIDTH + g_CursorX;
+
+    x86_outb(CRTC_INDEX_PORT, CRTC_CURSOR_LOCATION_HIGH);
+    x86_outb(CRTC_DATA_PORT, (uint8_t)(position >> 8));
+    x86_outb(CRTC_INDEX_PORT, CRTC_CURSOR_LOCATION_LOW);
+    x86_outb(CRTC_DATA_PORT, (uint8_t)(position & 0xFF));
+
+    bdaCursor[0] = g_CursorX;
+    bdaCursor[1] = g_CursorY;
+}
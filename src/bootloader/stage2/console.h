@@ -0,0 +1,7 @@
+#pragma once
+#include "stdint.h"
+
+void Console_Init();
+void Console_PutChar(char c);
+void Console_Write(const char* str, uint16_t length);
+void Console_Flush();
@@ -0,0 +1,239 @@
+/******************************************************************************
+ *  DESCRIPTION:
+ *      Multi-sector disk reads on top of the INT 13h wrappers in x86.asm
+ *      (see disk.h), with retries and splitting at the limits of the BIOS.
+ ******************************************************************************/
+
+#include "disk.h"
+#include "memory.h"
+#include "profile.h"
+#include "x86.h"
+
+/* One sector for reads whose buffer straddles a 64 KiB boundary. Stage2
+ * is a single 64 KiB segment starting on a 64 KiB boundary, so this one
+ * never does. */
+static uint8_t g_BounceBuffer[DISK_SECTOR_SIZE];
+
+/******************************************************************************
+ * Disk_Init
+ * ----------------------------------------------------------------------------
+ * Sets 'disk' up for the boot drive described by 'info'. The geometry is
+ * the BPB's, which stage1 already patched with what INT 13h AH=08h
+ * reported; the BIOS is only asked again if that left no usable geometry.
+ * Returns false if neither gives one.
+ ******************************************************************************/
+bool Disk_Init(Disk* disk, const BootInfo* info)
+{
+    uint8_t driveType;
+
+    disk->Id = info->BootDrive;
+    disk->HasExtensions = info->HasExtensions;
+    disk->BiosReads = 0;
+    disk->CacheHits = 0;
+    disk->CacheMisses = 0;
+    disk->UseClock = 0;
+    memset(disk->Cache, 0, sizeof(disk->Cache));
+
+    disk->Sectors = info->Bpb.SectorsPerTrack;
+    disk->Heads = info->Bpb.Heads;
+    disk->Cylinders = 0;
+
+    if ((disk->Sectors == 0 || disk->Heads == 0)
+        && !x86_Disk_GetDriveParams(disk->Id, &driveType, &disk->Cylinders, &disk->Sectors, &disk->Heads))
+        return false;
+
+    return disk->Sectors != 0 && disk->Heads != 0;
+}
+
+/******************************************************************************
+ * disk_lba_to_chs
+ * ----------------------------------------------------------------------------
+ * Converts an LBA to cylinder, head and (1-based) sector.
+ ******************************************************************************/
+static void disk_lba_to_chs(const Disk* disk, uint32_t lba, uint16_t* cylinderOut, uint16_t* sectorOut, uint16_t* headOut)
+{
+    uint32_t track = lba / disk->Sectors;
+
+    *sectorOut = (uint16_t)(lba % disk->Sectors) + 1;
+    *headOut = (uint16_t)(track % disk->Heads);
+    *cylinderOut = (uint16_t)(track / disk->Heads);
+}
+
+/******************************************************************************
+ * disk_read_chunk
+ * ----------------------------------------------------------------------------
+ * One BIOS read of 'count' sectors, retried DISK_READ_RETRIES times with a
+ * drive reset in between. The caller guarantees the chunk is one the BIOS
+ * accepts.
+ ******************************************************************************/
+static bool disk_read_chunk(Disk* disk, uint32_t lba, uint16_t count, void far* dataOut)
+{
+    uint16_t cylinder, sector, head;
+    uint16_t retries;
+    bool ok = false;
+
+    if (!disk->HasExtensions)
+        disk_lba_to_chs(disk, lba, &cylinder, &sector, &head);
+
+    Profile_Begin("disk read");
+    for (retries = 0; retries < DISK_READ_RETRIES && !ok; retries++)
+    {
+        if (retries > 0)
+            x86_Disk_Reset(disk->Id);
+
+        disk->BiosReads++;
+        if (disk->HasExtensions)
+            ok = x86_Disk_ReadLba(disk->Id, lba, count, dataOut);
+        else
+            ok = x86_Disk_Read(disk->Id, cylinder, sector, head, (uint8_t)count, dataOut);
+    }
+    Profile_End("disk read");
+
+    return ok;
+}
+
+/******************************************************************************
+ * disk_read_direct
+ * ----------------------------------------------------------------------------
+ * Reads 'count' sectors starting at absolute sector 'lba' to 'dataOut'.
+ * Each BIOS call covers as many sectors as possible, limited by:
+ *   - the end of the current track (CHS reads),
+ *   - the next 64 KiB physical boundary, which the ISA DMA controller
+ *     cannot cross,
+ *   - DISK_MAX_SECTORS_PER_READ.
+ * A sector that itself straddles a 64 KiB boundary goes through a bounce
+ * buffer. Returns false as soon as a chunk fails after all retries.
+ ******************************************************************************/
+static bool disk_read_direct(Disk* disk, uint32_t lba, uint16_t count, void far* dataOut)
+{
+    uint32_t address = ((uint32_t)FP_SEG(dataOut) << 4) + FP_OFF(dataOut);
+
+    while (count > 0)
+    {
+        uint16_t chunk = count;
+        uint16_t toBoundary = (uint16_t)((0x10000ul - (address & 0xFFFFul)) / DISK_SECTOR_SIZE);
+        void far* target = MK_FP(address >> 4, address & 0xF);
+
+        if (chunk > DISK_MAX_SECTORS_PER_READ)
+            chunk = DISK_MAX_SECTORS_PER_READ;
+
+        if (!disk->HasExtensions)
+        {
+            uint16_t left = disk->Sectors - (uint16_t)(lba % disk->Sectors);
+            if (chunk > left)
+                chunk = left;
+        }
+
+        if (toBoundary == 0)
+        {
+            /* Less than one sector fits before the boundary. */
+            if (!disk_read_chunk(disk, lba, 1, g_BounceBuffer))
+                return false;
+            memcpy(target, g_BounceBuffer, DISK_SECTOR_SIZE);
+            chunk = 1;
+        }
+        else
+        {
+            if (chunk > toBoundary)
+                chunk = toBoundary;
+            if (!disk_read_chunk(disk, lba, chunk, target))
+                return false;
+        }
+
+        lba += chunk;
+        count -= chunk;
+        address += (uint32_t)chunk * DISK_SECTOR_SIZE;
+    }
+
+    return true;
+}
+
+/******************************************************************************
+ * disk_cache_track
+ * ----------------------------------------------------------------------------
+ * Points *dataOut at the cached copy of the track that starts at
+ * 'trackLba', loading it into the least recently used line on a miss.
+ * Returns false if the track cannot be read whole.
+ ******************************************************************************/
+static bool disk_cache_track(Disk* disk, uint32_t trackLba, const uint8_t far** dataOut)
+{
+    DiskCacheLine* victim = &disk->Cache[0];
+    uint16_t i;
+
+    disk->UseClock++;
+
+    for (i = 0; i < DISK_CACHE_LINES; i++)
+    {
+        DiskCacheLine* line = &disk->Cache[i];
+
+        if (line->Valid && line->Lba == trackLba)
+        {
+            disk->CacheHits++;
+            line->LastUse = disk->UseClock;
+            *dataOut = MK_FP(DISK_CACHE_SEGMENT + i * DISK_CACHE_LINE_SEGMENTS, 0);
+            return true;
+        }
+
+        /* Least recently used, or better, empty. */
+        if (victim->Valid && (!line->Valid || line->LastUse < victim->LastUse))
+            victim = line;
+    }
+
+    disk->CacheMisses++;
+    i = victim - disk->Cache;
+    *dataOut = MK_FP(DISK_CACHE_SEGMENT + i * DISK_CACHE_LINE_SEGMENTS, 0);
+
+    victim->Valid = disk_read_chunk(disk, trackLba, disk->Sectors, (void far*)*dataOut);
+    victim->Lba = trackLba;
+    victim->LastUse = disk->UseClock;
+    return victim->Valid;
+}
+
+/******************************************************************************
+ * Disk_ReadSectors
+ * ----------------------------------------------------------------------------
+ * Reads 'count' sectors starting at absolute sector 'lba' to 'dataOut'.
+ * Reads shorter than a track are served from the track cache, one track
+ * at a time; if a track cannot be cached (e.g. the disk ends mid-track)
+ * the sectors are read directly. Returns false on a disk error.
+ ******************************************************************************/
+bool Disk_ReadSectors(Disk* disk, uint32_t lba, uint16_t count, void far* dataOut)
+{
+    uint8_t far* out = dataOut;
+
+    if (count >= disk->Sectors)
+        return disk_read_direct(disk, lba, count, dataOut);
+
+    while (count > 0)
+    {
+        uint16_t offset = (uint16_t)(lba % disk->Sectors);
+        uint16_t chunk = disk->Sectors - offset;
+        const uint8_t far* track;
+
+        if (chunk > count)
+            chunk = count;
+
+        if (disk_cache_track(disk, lba - offset, &track))
+            memcpy(out, track + offset * DISK_SECTOR_SIZE, chunk * DISK_SECTOR_SIZE);
+        else if (!disk_read_direct(disk, lba, chunk, out))
+            return false;
+
+        lba += chunk;
+        count -= chunk;
+        out += chunk * DISK_SECTOR_SIZE;
+    }
+
+    return true;
+}
+
+/******************************************************************************
+ * Disk_ReadSectorsUncached
+ * ----------------------------------------------------------------------------
+ * Like Disk_ReadSectors, but never touches the track cache, whatever the
+ * length. For bulk reads through a bounce buffer (file data), which would
+ * otherwise evict the cached FAT and directory tracks and be copied twice.
+ ******************************************************************************/
+bool Disk_ReadSectorsUncached(Disk* disk, uint32_t lba, uint16_t count, void far* dataOut)
+{
+    return disk_read_direct(disk, lba, count, dataOut);
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include "stdint.h"
+#include "handoff.h"
+
+/******************************************************************************
+ * BIOS disk driver.
+ *
+ * Reads whole sectors by absolute LBA through INT 13h: with the extensions
+ * (AH=42h) when stage1 found them, otherwise by CHS (AH=02h) using the
+ * geometry stage1 took from INT 13h AH=08h. Disk_ReadSectors issues as few
+ * BIOS calls as the BIOS allows and splits a read only where it has to (end
+ * of track for CHS, 64 KiB DMA boundaries, the per-call sector limit).
+ *
+ * Reads shorter than a track (FAT, directory and other metadata) go through
+ * an LRU cache of whole tracks at 7000:0000, so reading the same sectors
+ * again, or their neighbours on the same track, costs no BIOS call. Each
+ * track gets a 32 KiB slot (enough for 63 sectors), which keeps every fill
+ * clear of 64 KiB boundaries. Longer reads go straight to their buffer, as
+ * do all reads through Disk_ReadSectorsUncached.
+ ******************************************************************************/
+
+#define DISK_SECTOR_SIZE            512
+#define DISK_READ_RETRIES           3
+
+/* Sectors per INT 13h call: AH=02h takes a byte, and many EDD BIOSes
+ * reject more than 127 sectors per AH=42h packet. */
+#define DISK_MAX_SECTORS_PER_READ   127
+
+#define DISK_CACHE_SEGMENT          0x7000
+#define DISK_CACHE_LINES            4
+#define DISK_CACHE_LINE_SEGMENTS    0x0800      /* 32 KiB per line */
+
+typedef struct
+{
+    uint32_t Lba;                    // First sector of the cached track
+    uint16_t LastUse;                // Disk's UseClock at the last hit
+    bool     Valid;
+} DiskCacheLine;
+
+typedef struct
+{
+    uint8_t  Id;                     // BIOS drive number
+    bool     HasExtensions;          // Read with AH=42h
+    uint16_t Cylinders;              // 0 unless probed by Disk_Init
+    uint16_t Heads;
+    uint16_t Sectors;                // Per track
+
+    uint32_t BiosReads;              // INT 13h read calls issued
+    uint32_t CacheHits;              // Cached reads served from memory
+    uint32_t CacheMisses;            // Cached reads that had to load a track
+
+    DiskCacheLine Cache[DISK_CACHE_LINES];
+    uint16_t UseClock;
+} Disk;
+
+bool Disk_Init(Disk* disk, const BootInfo* info);
+bool Disk_ReadSectors(Disk* disk, uint32_t lba, uint16_t count, void far* dataOut);
+bool Disk_ReadSectorsUncached(Disk* disk, uint32_t lba, uint16_t count, void far* dataOut);
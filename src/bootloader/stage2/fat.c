@@ -0,0 +1,264 @@
+/******************************************************************************
+ *  DESCRIPTION:
+ *      FAT12 file system driver for stage2 (see fat.h): finds files in the
+ *      root directory and reads them run by run.
+ ******************************************************************************/
+
+#include "fat.h"
+#include "memory.h"
+#include "profile.h"
+#include "stdio.h"
+#include "pmode.h"
+#include "x86.h"
+
+static Disk* g_Disk;
+static const BootSector* g_Bpb;
+static uint32_t g_PartitionOffset;   // Partition LBAs -> disk LBAs
+static uint32_t g_DataLba;           // Partition LBA of cluster 2
+static uint16_t g_ClusterCount;      // Entries in g_Fat, incl. clusters 0 and 1
+
+#define g_RawFat                    ((uint8_t far*)MK_FP(FAT_WORK_SEGMENT, FAT_RAW_OFFSET))
+#define g_Fat                       ((uint16_t far*)MK_FP(FAT_WORK_SEGMENT, FAT_DECODED_OFFSET))
+#define g_RootDirectory             ((DirectoryEntry far*)MK_FP(FAT_WORK_SEGMENT, FAT_ROOT_OFFSET))
+#define g_BounceBuffer              MK_FP(FAT_WORK_SEGMENT, FAT_BOUNCE_OFFSET)
+#define FAT_BOUNCE_ADDRESS          (((uint32_t)FAT_WORK_SEGMENT << 4) + FAT_BOUNCE_OFFSET)
+#define FAT_BOUNCE_SECTORS          (FAT_BOUNCE_SIZE / DISK_SECTOR_SIZE)
+
+/******************************************************************************
+ * fat_read_sectors
+ * ----------------------------------------------------------------------------
+ * Reads 'count' sectors starting at partition LBA 'lba'. 'cachedIndex' is
+ * the index, within this range, of the first of 'cachedCount' sectors
+ * stage1 left at 'cache' (or HANDOFF_NO_SECTOR): those are copied, and
+ * only the parts before and after them are read from disk.
+ ******************************************************************************/
+static bool fat_read_sectors(uint32_t lba, uint16_t count, uint8_t far* dataOut,
+                             uint16_t cachedIndex, uint16_t cachedCount, const uint8_t far* cache)
+{
+    uint16_t cachedEnd;
+
+    if (cachedIndex >= count)
+        return Disk_ReadSectors(g_Disk, g_PartitionOffset + lba, count, dataOut);
+
+    cachedEnd = cachedIndex + cachedCount;
+    if (cachedEnd > count)
+        cachedEnd = count;
+
+    if (cachedIndex > 0
+        && !Disk_ReadSectors(g_Disk, g_PartitionOffset + lba, cachedIndex, dataOut))
+        return false;
+
+    memcpy(dataOut + cachedIndex * DISK_SECTOR_SIZE, cache,
+           (cachedEnd - cachedIndex) * DISK_SECTOR_SIZE);
+
+    if (cachedEnd < count
+        && !Disk_ReadSectors(g_Disk, g_PartitionOffset + lba + cachedEnd, count - cachedEnd,
+                             dataOut + cachedEnd * DISK_SECTOR_SIZE))
+        return false;
+
+    return true;
+}
+
+/******************************************************************************
+ * fat_decode
+ * ----------------------------------------------------------------------------
+ * Unpacks the raw FAT: every 3 bytes hold two 12-bit entries, the first in
+ * the low 12 bits and the second in the high 12 bits.
+ ******************************************************************************/
+static void fat_decode()
+{
+    const uint8_t far* raw = g_RawFat;
+    uint16_t i;
+
+    for (i = 0; i < g_ClusterCount; i += 2, raw += 3)
+    {
+        g_Fat[i] = raw[0] | ((uint16_t)(raw[1] & 0x0F) << 8);
+        g_Fat[i + 1] = (raw[1] >> 4) | ((uint16_t)raw[2] << 4);
+    }
+}
+
+/******************************************************************************
+ * Fat_EnableHighMemory
+ * ----------------------------------------------------------------------------
+ * Prepares loading above 1 MiB: turns on A20 and enters unreal mode.
+ * Returns false if A20 stays off, in which case only destinations below
+ * 640 KiB may be used.
+ ******************************************************************************/
+bool Fat_EnableHighMemory()
+{
+    if (!PMode_EnableA20())
+        return false;
+
+    x86_EnterUnrealMode();
+    return true;
+}
+
+/******************************************************************************
+ * Fat_Init
+ * ----------------------------------------------------------------------------
+ * Reads and decodes the first FAT and reads the root directory of the boot
+ * partition described by 'info'. Returns false on a disk error or if the
+ * volume does not fit the work area.
+ ******************************************************************************/
+bool Fat_Init(Disk* disk, const BootInfo* info)
+{
+    const BootSector* bpb = &info->Bpb;
+    uint32_t totalSectors = bpb->TotalSectors ? bpb->TotalSectors : bpb->LargeSectorCount;
+    uint16_t fatLba = bpb->ReservedSectors;
+    uint32_t rootLba;
+    uint16_t rootSectors;
+    uint32_t clusterCount;
+    uint16_t rootCachedIndex = HANDOFF_NO_SECTOR;
+    bool ok;
+
+    /* Check the BPB before deriving anything from it. The FAT and root
+     * directory sizes are compared as counts, since their byte sizes could
+     * wrap in 16 bits. */
+    if (bpb->SectorsPerCluster == 0 ||
+        bpb->SectorsPerFat > FAT_RAW_MAX_SIZE / DISK_SECTOR_SIZE ||
+        bpb->DirEntryCount > FAT_ROOT_MAX_SIZE / sizeof(DirectoryEntry))
+        return false;
+
+    rootLba = fatLba + (uint32_t)bpb->FatCount * bpb->SectorsPerFat;
+    rootSectors = (bpb->DirEntryCount * sizeof(DirectoryEntry) + DISK_SECTOR_SIZE - 1) / DISK_SECTOR_SIZE;
+    if (totalSectors <= rootLba + rootSectors)
+        return false;
+
+    clusterCount = (totalSectors - (rootLba + rootSectors)) / bpb->SectorsPerCluster + 2;
+    if (clusterCount > FAT_MAX_CLUSTERS)
+        return false;
+
+    g_Disk = disk;
+    g_Bpb = bpb;
+    g_PartitionOffset = info->PartitionOffset;
+    g_DataLba = rootLba + rootSectors;
+    g_ClusterCount = (uint16_t)clusterCount;
+
+    Profile_Begin("FAT init");
+
+    /* Root directory: reuse the sector stage1 found its file in. */
+    if (info->RootCachedLba != HANDOFF_NO_SECTOR && info->RootCachedLba >= rootLba)
+        rootCachedIndex = (uint16_t)(info->RootCachedLba - rootLba);
+    ok = fat_read_sectors(rootLba, rootSectors, (uint8_t far*)g_RootDirectory,
+                          rootCachedIndex, 1, info->RootCache);
+
+    /* First FAT: reuse the two sectors stage1 last walked. */
+    ok = ok && fat_read_sectors(fatLba, bpb->SectorsPerFat, g_RawFat,
+                                info->FatCachedSector, 2, info->FatCache);
+
+    if (ok)
+        fat_decode();
+
+    Profile_End("FAT init");
+    return ok;
+}
+
+/******************************************************************************
+ * Fat_FindFile
+ * ----------------------------------------------------------------------------
+ * Searches the root directory for 'name', given as the 11-byte 8.3 form
+ * (e.g. "KERNEL  BIN"). Returns NULL if there is no such file.
+ ******************************************************************************/
+const DirectoryEntry far* Fat_FindFile(const char* name)
+{
+    uint16_t i;
+
+    for (i = 0; i < g_Bpb->DirEntryCount; i++)
+    {
+        if (g_RootDirectory[i].Name[0] == 0)
+            break;                   // End of directory
+        if (memcmp(name, g_RootDirectory[i].Name, 11) == 0)
+            return &g_RootDirectory[i];
+    }
+
+    return NULL;
+}
+
+/******************************************************************************
+ * fat_read_run
+ * ----------------------------------------------------------------------------
+ * Reads 'count' sectors from partition LBA 'lba' to physical 'address'.
+ * Below 640 KiB the BIOS reads straight into place. Anywhere else the run
+ * goes through the bounce buffer, FAT_BOUNCE_SECTORS at a time, and is
+ * copied into place with x86_UnrealCopy. Those chunks bypass the track
+ * cache: they are shorter than a 63-sector track, so Disk_ReadSectors
+ * would cache them, evicting the FAT and root directory tracks and
+ * copying every sector twice.
+ ******************************************************************************/
+static bool fat_read_run(uint32_t lba, uint16_t count, uint32_t address)
+{
+    if (address + (uint32_t)count * DISK_SECTOR_SIZE <= FAT_LOW_MEMORY_END)
+        return Disk_ReadSectors(g_Disk, g_PartitionOffset + lba, count, MK_FP(address >> 4, address & 0xF));
+
+    while (count > 0)
+    {
+        uint16_t chunk = (count < FAT_BOUNCE_SECTORS) ? count : FAT_BOUNCE_SECTORS;
+
+        if (!Disk_ReadSectorsUncached(g_Disk, g_PartitionOffset + lba, chunk, g_BounceBuffer))
+            return false;
+        x86_UnrealCopy(address, FAT_BOUNCE_ADDRESS, (uint32_t)chunk * DISK_SECTOR_SIZE);
+
+        lba += chunk;
+        count -= chunk;
+        address += (uint32_t)chunk * DISK_SECTOR_SIZE;
+    }
+
+    return true;
+}
+
+/******************************************************************************
+ * Fat_ReadFile
+ * ----------------------------------------------------------------------------
+ * Reads the file 'entry' to physical 'address', which may be above 1 MiB
+ * once Fat_EnableHighMemory succeeded. The last cluster is read whole, so
+ * the destination must have room for the file rounded up to clusters.
+ * Nothing beyond that is written: a chain that runs on past the file's
+ * size (a corrupt or cyclic FAT) fails instead. Returns false on that or
+ * on a disk error. Stores the number of runs (one disk read each when
+ * below 640 KiB) in *runsOut.
+ ******************************************************************************/
+bool Fat_ReadFile(const DirectoryEntry far* entry, uint32_t address, uint16_t* runsOut)
+{
+    uint16_t cluster = entry->FirstClusterLow;
+    uint16_t maxRunLength = 0xFFFF / g_Bpb->SectorsPerCluster;
+    uint32_t clusterSize = (uint32_t)g_Bpb->SectorsPerCluster * DISK_SECTOR_SIZE;
+    uint32_t clustersLeft = (entry->Size + clusterSize - 1) / clusterSize;
+    uint16_t runs = 0;
+    bool ok = true;
+
+    Profile_Begin("FAT read file");
+    while (ok && cluster >= 2 && cluster < FAT_END_OF_CHAIN && cluster < g_ClusterCount)
+    {
+        uint16_t first = cluster;
+        uint16_t length = 1;
+        uint16_t sectors;
+
+        if (clustersLeft == 0)
+        {
+            ok = false;              // Chain longer than the file
+            break;
+        }
+
+        /* Extend the run while the chain continues with the next cluster
+         * (up to what one Disk_ReadSectors call can take, and no further
+         * than the file). */
+        while (g_Fat[cluster] == cluster + 1 && cluster + 1 < g_ClusterCount &&
+               length < maxRunLength && length < clustersLeft)
+        {
+            cluster++;
+            length++;
+        }
+        cluster = g_Fat[cluster];
+        clustersLeft -= length;
+
+        sectors = length * g_Bpb->SectorsPerCluster;
+        ok = fat_read_run(g_DataLba + (uint32_t)(first - 2) * g_Bpb->SectorsPerCluster, sectors, address);
+
+        address += (uint32_t)sectors * DISK_SECTOR_SIZE;
+        runs++;
+    }
+    Profile_End("FAT read file");
+
+    *runsOut = runs;
+    return ok;
+}
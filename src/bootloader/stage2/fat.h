@@ -0,0 +1,61 @@
+#pragma once
+#include "stdint.h"
+#include "disk.h"
+#include "handoff.h"
+
+/******************************************************************************
+ * FAT12 driver (the logic of tools/fat/fat.c, for stage2).
+ *
+ * Fat_Init reads the root directory and the first FAT once and decodes the
+ * FAT's 12-bit entries into a plain array of 16-bit ones, so following a
+ * chain is one array lookup per cluster. Fat_ReadFile groups a file's
+ * clusters into runs of consecutive clusters and reads each run with one
+ * Disk_ReadSectors call straight into the destination.
+ *
+ * The FAT, the decoded FAT and the root directory live in the work area at
+ * 1000:0000 (stage1's track buffer, free once stage2 runs). Sectors stage1
+ * still has cached (see handoff.h) are copied instead of read again.
+ *
+ * Files can be loaded anywhere in memory: runs that end above 640 KiB are
+ * read into a bounce buffer in the work area and copied into place from
+ * unreal mode (Fat_EnableHighMemory).
+ ******************************************************************************/
+
+#define FAT_WORK_SEGMENT            0x1000
+#define FAT_RAW_OFFSET              0x0000      /* Up to 12 sectors (FAT12 maximum) */
+#define FAT_RAW_MAX_SIZE            (FAT_DECODED_OFFSET - FAT_RAW_OFFSET)
+#define FAT_DECODED_OFFSET          0x3000      /* 2 bytes per cluster */
+#define FAT_ROOT_OFFSET             0x5000      /* Up to 16 KiB (512 entries) */
+#define FAT_ROOT_MAX_SIZE           0x4000
+#define FAT_BOUNCE_OFFSET           0x9000      /* Bounce buffer for high loads */
+#define FAT_BOUNCE_SIZE             0x7000
+#define FAT_LOW_MEMORY_END          0xA0000ul   /* BIOS reads straight below this */
+
+#define FAT_MAX_CLUSTERS            4086        /* FAT12 limit, incl. clusters 0 and 1 */
+#define FAT_END_OF_CHAIN            0x0FF8
+
+#pragma pack(push, 1)
+
+/* FAT12 directory entry, same layout as tools/fat/fat.c. */
+typedef struct
+{
+    uint8_t  Name[11];               // 8.3, space padded, no dot
+    uint8_t  Attributes;
+    uint8_t  _Reserved;
+    uint8_t  CreatedTimeTenths;
+    uint16_t CreatedTime;
+    uint16_t CreatedDate;
+    uint16_t AccessedDate;
+    uint16_t FirstClusterHigh;       // FAT32 only
+    uint16_t ModifiedTime;
+    uint16_t ModifiedDate;
+    uint16_t FirstClusterLow;
+    uint32_t Size;
+} DirectoryEntry;
+
+#pragma pack(pop)
+
+bool Fat_EnableHighMemory();
+bool Fat_Init(Disk* disk, const BootInfo* info);
+const DirectoryEntry far* Fat_FindFile(const char* name);
+bool Fat_ReadFile(const DirectoryEntry far* entry, uint32_t address, uint16_t* runsOut);
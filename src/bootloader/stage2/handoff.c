@@ -0,0 +1,39 @@
+/******************************************************************************
+ *  DESCRIPTION:
+ *      Takes over what stage1 learned about the boot disk (see handoff.h),
+ *      so stage2 neither probes the BIOS again nor re-reads the BPB, the
+ *      root directory or the FAT sectors stage1 already has in memory.
+ ******************************************************************************/
+
+#include "handoff.h"
+#include "memory.h"
+
+/******************************************************************************
+ * Handoff_Read
+ * ----------------------------------------------------------------------------
+ * Validates stage1's handoff block and fills 'info' from it and from the
+ * boot sector. Returns false if the block is missing or of another version,
+ * in which case 'info' must not be used.
+ ******************************************************************************/
+bool Handoff_Read(BootInfo* info)
+{
+    const Stage1Handoff far* handoff = HANDOFF_FAR(HANDOFF_BLOCK_ADDRESS);
+
+    if (handoff->Magic != HANDOFF_MAGIC || handoff->Version != HANDOFF_VERSION)
+        return false;
+
+    /* The BPB lives in another segment; copy it next to the rest. */
+    memcpy(&info->Bpb, HANDOFF_FAR(HANDOFF_BOOT_SECTOR_ADDRESS), sizeof(BootSector));
+
+    info->BootDrive = info->Bpb.DriveNumber;
+    info->HasExtensions = (handoff->DiskReadFunction == 0x42);
+    info->PartitionOffset = info->Bpb.HiddenSectors;
+    info->DataLba = handoff->DataLba;
+
+    info->RootCachedLba = handoff->RootCachedLba;
+    info->RootCache = HANDOFF_FAR(HANDOFF_ROOT_BUFFER_ADDRESS);
+    info->FatCachedSector = handoff->FatCachedSector;
+    info->FatCache = HANDOFF_FAR(HANDOFF_FAT_BUFFER_ADDRESS);
+
+    return true;
+}
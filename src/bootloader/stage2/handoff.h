@@ -0,0 +1,92 @@
+#pragma once
+#include "stdint.h"
+
+/******************************************************************************
+ * Stage1 -> stage2 handoff.
+ *
+ * Stage1 leaves the boot sector at 0000:7C00. Its BPB carries the geometry
+ * reported by INT 13h AH=08h, the boot drive and the partition offset
+ * (HiddenSectors), and the handoff block right after the EBPB says which
+ * disk sectors are still cached in conventional memory and whether INT 13h
+ * extensions are available. Keep in sync with src/bootloader/stage1/boot.asm.
+ ******************************************************************************/
+
+#define HANDOFF_MAGIC               0x4844      /* 'DH' */
+#define HANDOFF_VERSION             1
+
+#define HANDOFF_BOOT_SECTOR_ADDRESS 0x7C00
+#define HANDOFF_BLOCK_ADDRESS       0x7C3E
+#define HANDOFF_ROOT_BUFFER_ADDRESS 0x7E00      /* 1 root directory sector */
+#define HANDOFF_FAT_BUFFER_ADDRESS  0x8000      /* 2 FAT sectors */
+
+#define HANDOFF_NO_SECTOR           0xFFFF
+
+/* Build a far pointer to segment 0 : 'offset'. */
+#define HANDOFF_FAR(offset)         ((void far*)(uint32_t)(offset))
+
+#pragma pack(push, 1)
+
+/* FAT12 boot sector (BPB + EBPB), same layout as tools/fat/fat.c. */
+typedef struct
+{
+    uint8_t  BootJumpInstruction[3];
+    uint8_t  OemIdentifier[8];
+
+    uint16_t BytesPerSector;
+    uint8_t  SectorsPerCluster;
+    uint16_t ReservedSectors;
+    uint8_t  FatCount;
+    uint16_t DirEntryCount;
+    uint16_t TotalSectors;
+    uint8_t  MediaDescriptorType;
+    uint16_t SectorsPerFat;
+    uint16_t SectorsPerTrack;        // Patched by stage1 from INT 13h AH=08h
+    uint16_t Heads;                  // Patched by stage1 from INT 13h AH=08h
+    uint32_t HiddenSectors;          // LBA of the partition (0 on a floppy)
+    uint32_t LargeSectorCount;
+
+    uint8_t  DriveNumber;            // Stored by stage1 from DL at boot
+    uint8_t  _Reserved;
+    uint8_t  Signature;
+    uint32_t VolumeId;
+    uint8_t  VolumeLabel[11];
+    uint8_t  SystemId[8];
+} BootSector;
+
+/* Stage1 state, fixed at 0000:7C3E. */
+typedef struct
+{
+    uint16_t Magic;                  // HANDOFF_MAGIC
+    uint8_t  Version;                // HANDOFF_VERSION
+    uint8_t  DiskReadFunction;       // 0x02 = CHS, 0x42 = INT 13h extensions
+    uint16_t DataLba;                // First sector of cluster 2
+    uint16_t RootCachedLba;          // Root directory sector in the root buffer
+                                     // (LBAs are relative to the partition)
+    uint16_t FatCachedSector;        // FAT sector (from the first FAT) in the
+                                     // FAT buffer, followed by the next one
+} Stage1Handoff;
+
+#pragma pack(pop)
+
+/* What stage2 knows about the boot disk, taken over from stage1, and
+ * what it leaves behind for the kernel. Stage2 only: the kernel gets the
+ * fixed-layout KernelBootInfo built from it (pmode.h). */
+typedef struct
+{
+    BootSector Bpb;
+    uint8_t  BootDrive;
+    bool     HasExtensions;
+    uint32_t PartitionOffset;
+    uint16_t DataLba;
+
+    uint16_t RootCachedLba;          // HANDOFF_NO_SECTOR if nothing is cached
+    const uint8_t far* RootCache;
+    uint16_t FatCachedSector;        // HANDOFF_NO_SECTOR if nothing is cached
+    const uint8_t far* FatCache;
+
+    uint32_t BootLogAddress;         // Physical address of the BootLog
+    uint32_t KernelAddress;          // Physical address KERNEL.BIN was loaded to
+    uint32_t KernelSize;             // Size of KERNEL.BIN in bytes
+} BootInfo;
+
+bool Handoff_Read(BootInfo* info);
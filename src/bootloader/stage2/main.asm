@@ -5,17 +5,30 @@ section _ENTRY class=CODE
 extern _cstart_
 global entry
 
+; Boot timeline slot for "stage2 loaded" (see timeline.h).
+BIOS_TICKS              equ 046Ch
+TL_STAGE2_LOADED        equ 0506h
+
 entry:
     cli
 
-    mov ax, ds
+    ; Stamp our arrival with the BIOS tick count before anything else.
+    xor ax, ax
+    mov es, ax
+    mov ax, [es:BIOS_TICKS]
+    mov [es:TL_STAGE2_LOADED], ax
+
+    ; Stage1 far-jumps here with only CS pointing at us. Everything else it
+    ; knows (drive, geometry, cached sectors) is in its handoff block, which
+    ; cstart_ reads, so set up DS = ES = SS = CS ourselves.
+    mov ax, cs
+    mov ds, ax
+    mov es, ax
     mov ss, ax
     mov sp, 0
     mov bp, sp
     sti
 
-    xor dh, dh
-    push dx
     call _cstart_
 
     cli
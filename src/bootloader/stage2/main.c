@@ -1,14 +1,170 @@
 #include "stdint.h"
 #include "stdio.h"
+#include "console.h"
+#include "bootlog.h"
+#include "handoff.h"
+#include "disk.h"
+#include "fat.h"
+#include "memory.h"
+#include "timeline.h"
+#include "profile.h"
+#include "pmode.h"
+#include "x86.h"
 
-void _cdecl cstart_(uint16_t bootDrive)
+/* KERNEL.BIN is a flat 32-bit binary, loaded at 1 MiB and entered at its
+ * first byte in protected mode (see pmode.h). It may extend up to the ISA
+ * memory hole at 15 MiB. */
+#define KERNEL_FILE_NAME        "KERNEL  BIN"
+#define KERNEL_LOAD_ADDRESS     0x00100000ul
+#define KERNEL_MAX_SIZE         (0x00F00000ul - KERNEL_LOAD_ADDRESS)
+
+BootInfo g_BootInfo;
+Disk g_Disk;
+
+/* The printf benchmark costs boot time, so it is only built with
+ * -dSTAGE2_BENCHMARK. */
+#ifdef STAGE2_BENCHMARK
+
+#define BENCHMARK_ITERATIONS 64
+
+/* TSC cycles per iteration between two stamps. */
+static uint32_t cycles_per_iteration(uint64_t start, uint64_t end)
+{
+    uint64_t cycles;
+    uint32_t rem;
+
+    x86_div64_32(end - start, BENCHMARK_ITERATIONS, &cycles, &rem);
+    return (uint32_t)cycles;
+}
+
+/* Times printf's integer formatting with all outputs switched off, so only
+ * the formatting itself is measured, and prints the cycles per number. */
+static void benchmark_printf_number()
+{
+    uint64_t start, end;
+    uint32_t dec16, dec32, dec64, hex64;
+    int i;
+
+    stdio_SetOutputs(0);
+
+    x86_ReadTsc(&start);
+    for (i = 0; i < BENCHMARK_ITERATIONS; i++)
+        printf("%d", -12345);
+    x86_ReadTsc(&end);
+    dec16 = cycles_per_iteration(start, end);
+
+    x86_ReadTsc(&start);
+    for (i = 0; i < BENCHMARK_ITERATIONS; i++)
+        printf("%ld", -1234567890l);
+    x86_ReadTsc(&end);
+    dec32 = cycles_per_iteration(start, end);
+
+    x86_ReadTsc(&start);
+    for (i = 0; i < BENCHMARK_ITERATIONS; i++)
+        printf("%llu", 10200300400ull);
+    x86_ReadTsc(&end);
+    dec64 = cycles_per_iteration(start, end);
+
+    x86_ReadTsc(&start);
+    for (i = 0; i < BENCHMARK_ITERATIONS; i++)
+        printf("%llx", 0xdeadbeeffeebdaedull);
+    x86_ReadTsc(&end);
+    hex64 = cycles_per_iteration(start, end);
+
+    stdio_SetOutputs(STDIO_DEFAULT_OUTPUTS);
+    printf("printf cycles/number: %%d %lu, %%ld %lu, %%llu %lu, %%llx %lu\r\n",
+           dec16, dec32, dec64, hex64);
+}
+
+#endif
+
+/* Finds KERNEL.BIN on the boot partition and reads it to
+ * KERNEL_LOAD_ADDRESS. Prints why if it cannot. */
+static bool load_kernel()
+{
+    const DirectoryEntry far* kernel;
+    uint16_t runs;
+
+    if (!Disk_Init(&g_Disk, &g_BootInfo) || !Fat_Init(&g_Disk, &g_BootInfo))
+    {
+        puts("Disk read error!\r\n");
+        return false;
+    }
+
+    if (!Fat_EnableHighMemory())
+    {
+        puts("Cannot enable A20!\r\n");
+        return false;
+    }
+
+    kernel = Fat_FindFile(KERNEL_FILE_NAME);
+    if (kernel == NULL || kernel->Size > KERNEL_MAX_SIZE)
+    {
+        puts("KERNEL.BIN not found or too large!\r\n");
+        return false;
+    }
+
+    if (!Fat_ReadFile(kernel, KERNEL_LOAD_ADDRESS, &runs))
+    {
+        puts("KERNEL.BIN read error!\r\n");
+        return false;
+    }
+
+    g_BootInfo.KernelAddress = KERNEL_LOAD_ADDRESS;
+    g_BootInfo.KernelSize = kernel->Size;
+    printf("Loaded KERNEL.BIN: %lu bytes in %u runs, %lu BIOS reads in total\r\n",
+           kernel->Size, runs, g_Disk.BiosReads);
+    return true;
+}
+
+void _cdecl cstart_()
 {
     const char far* far_str = "far string";
+    char line[64];
+
+    Timeline_StampCstart();
+    Console_Init();
+    BootLog_Init();
+    stdio_SetOutputs(STDIO_DEFAULT_OUTPUTS);
+
+    Profile_Begin("handoff");
+    if (!Handoff_Read(&g_BootInfo))
+    {
+        puts("stage1 handoff block missing!\r\n");
+        for(;;);
+    }
+    g_BootInfo.BootLogAddress = BOOTLOG_ADDRESS;
+    Profile_End("handoff");
+
+    printf("Boot drive %x, %u heads, %u sectors/track, partition at %lu, data at %u, %s reads\r\n",
+           g_BootInfo.BootDrive, g_BootInfo.Bpb.Heads, g_BootInfo.Bpb.SectorsPerTrack,
+           g_BootInfo.PartitionOffset, g_BootInfo.DataLba,
+           g_BootInfo.HasExtensions ? "LBA" : "CHS");
+
+    if (!load_kernel())
+        for(;;);
 
     puts("C says hello to the ducks!\r\n");
     printf("Formatted %% %c %s %ls\r\n", 'a', "string", far_str);
     printf("Formatted %d %i %x %p %o %hd %hi %hhu %hhd\r\n", 1234, -5678, 0xdead, 0xbeef, 012345, (short)27, (short)-42, (unsigned char)20, (signed char)-10);
     printf("Formatted %ld %lx %lld %llx\r\n", -100000000l, 0xdeadbeeful, 10200300400ll, 0xdeadbeeffeebdaedull);
+    snprintf(line, sizeof(line), "Formatted %s %u %lx %c", "into memory", 65535u, 0xcafebabeul, '!');
+    printf("%s\r\n", line);
+
+#ifdef STAGE2_BENCHMARK
+    Profile_Begin("printf benchmark");
+    benchmark_printf_number();
+    Profile_End("printf benchmark");
+#endif
+
+    /* The timeline always goes to serial, for the test rig to pick up. */
+    stdio_SetOutputs(STDIO_DEFAULT_OUTPUTS | STDIO_OUTPUT_SERIAL);
+    Timeline_Print();
+    Profile_Print();
+    printf("Disk I/O: %lu cache hits, %lu cache misses, %lu BIOS reads\r\n",
+           g_Disk.CacheHits, g_Disk.CacheMisses, g_Disk.BiosReads);
+    stdio_SetOutputs(STDIO_DEFAULT_OUTPUTS);
+    flush();
 
-    for(;;);
+    PMode_EnterKernel(KERNEL_LOAD_ADDRESS, &g_BootInfo);
 }
@@ -0,0 +1,20 @@
+#pragma once
+#include "stdint.h"
+
+/* Real-mode far pointers: build one from segment:offset, or take it apart. */
+#define MK_FP(segment, offset)      ((void far*)(((uint32_t)(segment) << 16) | (uint16_t)(offset)))
+#define FP_SEG(pointer)             ((uint16_t)((uint32_t)(void far*)(pointer) >> 16))
+#define FP_OFF(pointer)             ((uint16_t)(uint32_t)(void far*)(pointer))
+
+/******************************************************************************
+ * Far-pointer memory primitives (x86.asm).
+ *
+ * All three move dwords with REP MOVSD / STOSD / CMPSD and handle the odd
+ * bytes separately, so they are the fast way to copy, fill or compare
+ * memory anywhere in the first megabyte. A block must not cross the end of
+ * its segment (num is at most 64 KiB).
+ ******************************************************************************/
+
+void far* _cdecl memcpy(void far* dst, const void far* src, uint16_t num);
+void far* _cdecl memset(void far* dst, int value, uint16_t num);
+int _cdecl memcmp(const void far* ptr1, const void far* ptr2, uint16_t num);
@@ -0,0 +1,61 @@
+/******************************************************************************
+ *  DESCRIPTION:
+ *      Enables the A20 gate and hands control to a 32-bit kernel in
+ *      protected mode (see pmode.h).
+ ******************************************************************************/
+
+#include "pmode.h"
+#include "memory.h"
+#include "x86.h"
+
+static KernelBootInfo g_KernelBootInfo;
+
+/******************************************************************************
+ * PMode_EnableA20
+ * ----------------------------------------------------------------------------
+ * Turns on A20, trying the fast gate (port 92h) first and the keyboard
+ * controller second, and verifying after each. Returns false if A20 is
+ * still off; memory above 1 MiB is then unusable.
+ ******************************************************************************/
+bool PMode_EnableA20()
+{
+    uint16_t i;
+
+    if (x86_A20_IsEnabled())
+        return true;
+
+    x86_A20_EnableFast();
+    if (x86_A20_IsEnabled())
+        return true;
+
+    x86_A20_EnableKeyboardController();
+    for (i = 0; i < PMODE_A20_VERIFY_RETRIES; i++)
+    {
+        if (x86_A20_IsEnabled())
+            return true;
+    }
+
+    return false;
+}
+
+/******************************************************************************
+ * PMode_EnterKernel
+ * ----------------------------------------------------------------------------
+ * Switches to protected mode and jumps to physical address 'entry', passing
+ * the physical address of a KernelBootInfo filled in from 'info'. A20 must
+ * be on. Does not return.
+ ******************************************************************************/
+void PMode_EnterKernel(uint32_t entry, const BootInfo* info)
+{
+    const void far* farInfo = &g_KernelBootInfo;
+
+    g_KernelBootInfo.Magic = KERNEL_BOOT_INFO_MAGIC;
+    g_KernelBootInfo.Size = sizeof(KernelBootInfo);
+    g_KernelBootInfo.BootDrive = info->BootDrive;
+    g_KernelBootInfo.PartitionOffset = info->PartitionOffset;
+    g_KernelBootInfo.BootLogAddress = info->BootLogAddress;
+    g_KernelBootInfo.KernelAddress = info->KernelAddress;
+    g_KernelBootInfo.KernelSize = info->KernelSize;
+
+    x86_EnterProtectedMode(entry, ((uint32_t)FP_SEG(farInfo) << 4) + FP_OFF(farInfo));
+}
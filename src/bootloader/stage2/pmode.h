@@ -0,0 +1,40 @@
+#pragma once
+#include "stdint.h"
+#include "handoff.h"
+
+/******************************************************************************
+ * Protected-mode handoff.
+ *
+ * Stage2 ends by entering a 32-bit kernel: A20 on, the flat GDT from
+ * x86.asm loaded (code 08h, data 10h, both base 0 and limit 4 GiB),
+ * CR0.PE set, and a far jump to the kernel's physical entry address with
+ * EBX (and [ESP+4]) pointing at a KernelBootInfo. Interrupts stay off.
+ ******************************************************************************/
+
+/* Times x86_A20_IsEnabled is polled after the keyboard controller method,
+ * which can take effect with a delay. */
+#define PMODE_A20_VERIFY_RETRIES    1000
+
+#define KERNEL_BOOT_INFO_MAGIC      0x4B435544ul    /* 'DUCK' */
+
+#pragma pack(push, 1)
+
+/* What the kernel gets from stage2. This is an ABI: fields have fixed
+ * offsets, hold only 32-bit values and physical addresses, and new ones
+ * are only ever appended (Size tells the kernel which are present). Keep
+ * in sync with src/kernel/main.asm. */
+typedef struct
+{
+    uint32_t Magic;                  // +0:  KERNEL_BOOT_INFO_MAGIC
+    uint32_t Size;                   // +4:  sizeof(KernelBootInfo)
+    uint32_t BootDrive;              // +8:  BIOS drive number
+    uint32_t PartitionOffset;        // +12: LBA of the boot partition
+    uint32_t BootLogAddress;         // +16: Physical address of the BootLog
+    uint32_t KernelAddress;          // +20: Physical address KERNEL.BIN was loaded to
+    uint32_t KernelSize;             // +24: Size of KERNEL.BIN in bytes
+} KernelBootInfo;
+
+#pragma pack(pop)
+
+bool PMode_EnableA20();
+void PMode_EnterKernel(uint32_t entry, const BootInfo* info);
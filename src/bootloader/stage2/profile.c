@@ -0,0 +1,122 @@
+/******************************************************************************
+ *  DESCRIPTION:
+ *      Accumulates TSC cycles per named scope (see profile.h) and prints
+ *      them as a table, to see where stage2 spends its time.
+ ******************************************************************************/
+
+#include "profile.h"
+#include "stdio.h"
+#include "x86.h"
+
+static ProfileScope g_Scopes[PROFILE_MAX_SCOPES];
+static uint16_t g_ScopeCount = 0;
+
+/******************************************************************************
+ * same_name
+ * ----------------------------------------------------------------------------
+ * Compares two scope names; the pointer test settles the usual case where
+ * both calls pass the same literal.
+ ******************************************************************************/
+static bool same_name(const char* a, const char* b)
+{
+    if (a == b)
+        return true;
+
+    while (*a && *a == *b)
+    {
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+/******************************************************************************
+ * find_scope
+ * ----------------------------------------------------------------------------
+ * Returns the scope called 'name', creating it if there is room, or NULL
+ * once PROFILE_MAX_SCOPES scopes exist.
+ ******************************************************************************/
+static ProfileScope* find_scope(const char* name)
+{
+    ProfileScope* scope;
+    uint16_t i;
+
+    for (i = 0; i < g_ScopeCount; i++)
+    {
+        if (same_name(g_Scopes[i].Name, name))
+            return &g_Scopes[i];
+    }
+
+    if (g_ScopeCount == PROFILE_MAX_SCOPES)
+        return NULL;
+
+    scope = &g_Scopes[g_ScopeCount++];
+    scope->Name = name;
+    scope->Total = 0;
+    scope->Max = 0;
+    scope->Count = 0;
+    return scope;
+}
+
+/******************************************************************************
+ * Profile_Begin
+ * ----------------------------------------------------------------------------
+ * Opens a pass through scope 'name'. The TSC is read last, so the lookup
+ * is not counted.
+ ******************************************************************************/
+void Profile_Begin(const char* name)
+{
+    ProfileScope* scope = find_scope(name);
+
+    if (scope != NULL)
+        x86_ReadTsc(&scope->Start);
+}
+
+/******************************************************************************
+ * Profile_End
+ * ----------------------------------------------------------------------------
+ * Closes the pass through scope 'name' opened by Profile_Begin. The TSC is
+ * read first, so the lookup is not counted.
+ ******************************************************************************/
+void Profile_End(const char* name)
+{
+    ProfileScope* scope;
+    uint64_t end;
+    uint64_t cycles;
+
+    x86_ReadTsc(&end);
+
+    scope = find_scope(name);
+    if (scope == NULL)
+        return;
+
+    cycles = end - scope->Start;
+    scope->Total += cycles;
+    scope->Count++;
+    if (x86_cmp64(cycles, scope->Max) > 0)
+        scope->Max = cycles;
+}
+
+/******************************************************************************
+ * Profile_Print
+ * ----------------------------------------------------------------------------
+ * Prints one row per scope: calls, total, average and max cycles.
+ ******************************************************************************/
+void Profile_Print()
+{
+    uint16_t i;
+
+    printf("Profile (TSC cycles):\r\n");
+    for (i = 0; i < g_ScopeCount; i++)
+    {
+        const ProfileScope* scope = &g_Scopes[i];
+        uint64_t average = 0;
+        uint32_t rem;
+
+        if (scope->Count > 0)
+            x86_div64_32(scope->Total, scope->Count, &average, &rem);
+
+        printf("  %s: %lu calls, total %llu, avg %llu, max %llu\r\n",
+               scope->Name, scope->Count, scope->Total, average, scope->Max);
+    }
+}
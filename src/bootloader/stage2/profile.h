@@ -0,0 +1,27 @@
+#pragma once
+#include "stdint.h"
+
+/******************************************************************************
+ * Scope profiler.
+ *
+ * Profile_Begin / Profile_End bracket a named piece of stage2; every pass
+ * through it adds its length in TSC cycles to the scope's total and bumps
+ * its call count and, if longer, its max. Scopes may nest as long as each
+ * name is only open once at a time. Names are compared by pointer first,
+ * so pass the same string literal to both calls.
+ ******************************************************************************/
+
+#define PROFILE_MAX_SCOPES          16
+
+typedef struct
+{
+    const char* Name;
+    uint64_t Start;                  // TSC at the open Profile_Begin
+    uint64_t Total;                  // Cycles in all completed passes
+    uint64_t Max;                    // Cycles in the longest pass
+    uint32_t Count;                  // Completed passes
+} ProfileScope;
+
+void Profile_Begin(const char* name);
+void Profile_End(const char* name);
+void Profile_Print();
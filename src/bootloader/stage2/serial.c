@@ -0,0 +1,76 @@
+/******************************************************************************
+ *  DESCRIPTION:
+ *      Polled driver for a 16550 UART (COM1 at 3F8h on PCs and QEMU).
+ *
+ *      With its FIFOs enabled the 16550 raises THRE ("transmit holding
+ *      register empty") only once the whole 16-byte transmit FIFO has
+ *      drained, so every poll that sees THRE can hand it 16 bytes at once,
+ *      instead of one byte per poll (or per INT 14h call).
+ ******************************************************************************/
+
+#include "serial.h"
+#include "x86.h"
+
+/* Register offsets from the base port. */
+#define SERIAL_REG_DATA             0           /* DLAB=0: THR / RBR */
+#define SERIAL_REG_DIVISOR_LOW      0           /* DLAB=1 */
+#define SERIAL_REG_INTERRUPT_ENABLE 1           /* DLAB=0 */
+#define SERIAL_REG_DIVISOR_HIGH     1           /* DLAB=1 */
+#define SERIAL_REG_FIFO_CONTROL     2
+#define SERIAL_REG_LINE_CONTROL     3
+#define SERIAL_REG_MODEM_CONTROL    4
+#define SERIAL_REG_LINE_STATUS      5
+
+#define SERIAL_LCR_8N1              0x03
+#define SERIAL_LCR_DLAB             0x80
+#define SERIAL_FCR_ENABLE_AND_CLEAR 0xC7        /* Enable, clear RX/TX, 14-byte RX trigger */
+#define SERIAL_MCR_DTR_RTS          0x03
+#define SERIAL_LSR_THRE             0x20
+
+#define SERIAL_FIFO_SIZE            16
+
+/******************************************************************************
+ * Serial_Init
+ * ----------------------------------------------------------------------------
+ * Sets the UART at 'port' to 115200 / 'divisor' baud (SERIAL_DIVISOR_*), 8
+ * data bits, no parity, 1 stop bit, with interrupts off and the FIFOs
+ * enabled. Callers pass one of the constant divisors, so nothing has to
+ * be worked out from a baud rate at run time.
+ ******************************************************************************/
+void Serial_Init(uint16_t port, uint16_t divisor)
+{
+    x86_outb(port + SERIAL_REG_INTERRUPT_ENABLE, 0x00);
+
+    x86_outb(port + SERIAL_REG_LINE_CONTROL, SERIAL_LCR_DLAB);
+    x86_outb(port + SERIAL_REG_DIVISOR_LOW, (uint8_t)(divisor & 0xFF));
+    x86_outb(port + SERIAL_REG_DIVISOR_HIGH, (uint8_t)(divisor >> 8));
+    x86_outb(port + SERIAL_REG_LINE_CONTROL, SERIAL_LCR_8N1);
+
+    x86_outb(port + SERIAL_REG_FIFO_CONTROL, SERIAL_FCR_ENABLE_AND_CLEAR);
+    x86_outb(port + SERIAL_REG_MODEM_CONTROL, SERIAL_MCR_DTR_RTS);
+}
+
+/******************************************************************************
+ * Serial_Write
+ * ----------------------------------------------------------------------------
+ * Sends 'length' bytes from 'data', refilling the transmit FIFO up to 16
+ * bytes at a time whenever it has drained. If no UART is present the
+ * status register reads FFh, which looks drained, so this never hangs.
+ ******************************************************************************/
+void Serial_Write(uint16_t port, const char* data, uint16_t length)
+{
+    while (length > 0)
+    {
+        uint16_t chunk = (length < SERIAL_FIFO_SIZE) ? length : SERIAL_FIFO_SIZE;
+        uint16_t i;
+
+        while (!(x86_inb(port + SERIAL_REG_LINE_STATUS) & SERIAL_LSR_THRE))
+            ;
+
+        for (i = 0; i < chunk; i++)
+            x86_outb(port + SERIAL_REG_DATA, (uint8_t)data[i]);
+
+        data += chunk;
+        length -= chunk;
+    }
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include "stdint.h"
+
+#define SERIAL_COM1_PORT            0x3F8
+
+/* Divisors of the UART's 115200 Hz baud clock (1.8432 MHz / 16). */
+#define SERIAL_DIVISOR_115200       1
+#define SERIAL_DIVISOR_57600        2
+#define SERIAL_DIVISOR_38400        3
+#define SERIAL_DIVISOR_19200        6
+#define SERIAL_DIVISOR_9600         12
+#define SERIAL_DEFAULT_DIVISOR      SERIAL_DIVISOR_115200
+
+void Serial_Init(uint16_t port, uint16_t divisor);
+void Serial_Write(uint16_t port, const char* data, uint16_t length);
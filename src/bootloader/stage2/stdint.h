@@ -4,8 +4,14 @@ typedef signed char int8_t;
 typedef unsigned char uint8_t;
 typedef signed short int16_t;
 typedef unsigned short uint16_t;
+#ifndef __LP64__
 typedef signed long int int32_t;
 typedef unsigned long int uint32_t;
+#else
+/* 64-bit host build of the stdio tests (tools/stdio_test). */
+typedef signed int int32_t;
+typedef unsigned int uint32_t;
+#endif
 typedef signed long long int int64_t;
 typedef unsigned long long int uint64_t;
 
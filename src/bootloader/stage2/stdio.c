@@ -1,21 +1,25 @@
 /******************************************************************************
  *  DESCRIPTION:
  *      A heavily documented single-file example of a simplified printf-like
- *      implementation for x86 environments. It uses a custom low-level
- *      function to write characters directly to the screen (x86_Video_WriteCharTeletype).
+ *      implementation for x86 environments. It writes characters directly
+ *      into VGA text memory through the console driver (console.c).
  *
  *      This file provides:
- *          - putc(...)   : Output a single character
+ *          - stdio_SetOutputs(...) : Choose screen, serial and/or boot log output
+ *          - flush()     : Write out buffered output
+ *          - putc(...)   : Output a single character (buffered)
  *          - puts(...)   : Output a standard (near) string
  *          - puts_f(...) : Output a far string
- *          - printf(...) : A simplified printf implementation
+ *          - vformat(...) : The formatting core, writing to a FormatSink
+ *          - printf(...), vprintf(...) : Format to stdout (putc)
+ *          - snprintf(...), vsnprintf(...) : Format into a memory buffer
  *          - printf_number(...) : Helper function to handle integer conversions
  *
  *      NOTE:
  *      - The code uses some assumptions about x86 calling conventions for
  *        handling variable arguments.
  *      - The code expects definitions for:
- *           x86_Video_WriteCharTeletype(...)
+ *           Console_PutChar(...), Console_Flush()
  *           x86_div64_32(...)
  *        in "x86.h", which is not provided here.
  *      - The code is for demonstration/learning in a low-level or kernel-like
@@ -25,19 +29,101 @@
 
 #include "stdio.h"   /* Potentially for function declarations. */
 #include "x86.h"     /* Must contain declarations for x86-specific routines. */
+#include "console.h" /* Direct VGA text-memory console. */
+#include "serial.h"  /* 16550 serial port driver. */
+#include "bootlog.h" /* In-memory boot log. */
+#include "profile.h" /* Per-device output cost. */
+
+/* Where flush sends characters (STDIO_OUTPUT_* flags). */
+static uint8_t g_Outputs = STDIO_OUTPUT_SCREEN;
+
+/* Port of the serial output. */
+#define STDIO_SERIAL_PORT           SERIAL_COM1_PORT
+
+/* Profiler scopes, one per output device. */
+static const char g_ProfileScreen[] = "screen output";
+static const char g_ProfileSerial[] = "serial output";
+static const char g_ProfileLog[] = "boot log output";
+
+/* Output collected by putc until the next flush. */
+static char g_OutputBuffer[STDIO_BUFFER_SIZE];
+static uint16_t g_OutputLength = 0;
+
+/******************************************************************************
+ * stdio_SetOutputs
+ * ----------------------------------------------------------------------------
+ * Selects the devices putc writes to, as a combination of STDIO_OUTPUT_*
+ * flags: the screen, the serial port, the boot log, or any mix of them
+ * (mirrored). The serial port (COM1) is initialised the first time it is
+ * selected; the boot log must have been set up with BootLog_Init().
+ ******************************************************************************/
+void stdio_SetOutputs(uint8_t outputs)
+{
+    static bool serialReady = false;
+
+    /* Buffered text belongs to the outputs it was printed for. */
+    flush();
+
+    if ((outputs & STDIO_OUTPUT_SERIAL) && !serialReady)
+    {
+        Serial_Init(STDIO_SERIAL_PORT, SERIAL_DEFAULT_DIVISOR);
+        serialReady = true;
+    }
+
+    g_Outputs = outputs;
+}
+
+/******************************************************************************
+ * flush
+ * ----------------------------------------------------------------------------
+ * Writes everything putc has buffered to the screen with one
+ * Console_Write() (followed by a single hardware cursor update), to COM1
+ * with one Serial_Write(), and/or to the boot log with one BootLog_Write(),
+ * as chosen by stdio_SetOutputs. Each device's time is profiled.
+ ******************************************************************************/
+void flush()
+{
+    if (g_OutputLength == 0)
+        return;
+
+    if (g_Outputs & STDIO_OUTPUT_SCREEN)
+    {
+        Profile_Begin(g_ProfileScreen);
+        Console_Write(g_OutputBuffer, g_OutputLength);
+        Console_Flush();
+        Profile_End(g_ProfileScreen);
+    }
+
+    if (g_Outputs & STDIO_OUTPUT_SERIAL)
+    {
+        Profile_Begin(g_ProfileSerial);
+        Serial_Write(STDIO_SERIAL_PORT, g_OutputBuffer, g_OutputLength);
+        Profile_End(g_ProfileSerial);
+    }
+
+    if (g_Outputs & STDIO_OUTPUT_LOG)
+    {
+        Profile_Begin(g_ProfileLog);
+        BootLog_Write(g_OutputBuffer, g_OutputLength);
+        Profile_End(g_ProfileLog);
+    }
+
+    g_OutputLength = 0;
+}
 
 /******************************************************************************
  * putc
  * ----------------------------------------------------------------------------
- * Writes a single character to the screen using x86_Video_WriteCharTeletype().
- * This function is the simplest possible wrapper around the low-level API.
+ * Appends a single character to the output buffer. The buffer is flushed
+ * at the end of every line ('\n') and whenever it fills up; text without
+ * a newline only appears once someone calls flush().
  ******************************************************************************/
 void putc(char c)
 {
-    /* x86_Video_WriteCharTeletype(char c, int attribute)
-     * In typical VGA text mode, 'attribute' might control color or other text
-     * attributes. Here we pass 0 for default or inherited attributes. */
-    x86_Video_WriteCharTeletype(c, 0);
+    g_OutputBuffer[g_OutputLength++] = c;
+
+    if (c == '\n' || g_OutputLength == STDIO_BUFFER_SIZE)
+        flush();
 }
 
 /******************************************************************************
@@ -103,14 +189,57 @@ void puts_f(const char far* str)
 #define PRINTF_LENGTH_LONG          3
 #define PRINTF_LENGTH_LONG_LONG     4
 
+/******************************************************************************
+ * PRINTF_ARG_SLOTS
+ * ----------------------------------------------------------------------------
+ * Number of 'int' stack units an argument of 'type' occupies. Under Watcom
+ * (16-bit int) this is 1 for near pointers, 2 for long and far pointers and
+ * 4 for long long; spelling it out keeps the walker right for the host
+ * build of the stdio tests (tools/stdio_test) too.
+ ******************************************************************************/
+#define PRINTF_ARG_SLOTS(type)      ((sizeof(type) + sizeof(int) - 1) / sizeof(int))
+
 /******************************************************************************
  * Forward declaration for the helper function that prints numbers:
  ******************************************************************************/
-int* printf_number(int* argp, int length, bool sign, int radix);
+int* printf_number(FormatSink* sink, int* argp, int length, bool sign, int radix);
+
+/******************************************************************************
+ * sink_putc
+ * ----------------------------------------------------------------------------
+ * Hands one character to a sink and counts it.
+ ******************************************************************************/
+static void sink_putc(FormatSink* sink, char c)
+{
+    sink->PutChar(sink, c);
+    sink->Count++;
+}
+
+/******************************************************************************
+ * sink_puts / sink_puts_f
+ * ----------------------------------------------------------------------------
+ * Hand a near / far null-terminated string to a sink.
+ ******************************************************************************/
+static void sink_puts(FormatSink* sink, const char* str)
+{
+    while (*str)
+        sink_putc(sink, *str++);
+}
+
+static void sink_puts_f(FormatSink* sink, const char far* str)
+{
+    while (*str)
+        sink_putc(sink, *str++);
+}
 
 /******************************************************************************
- * printf
+ * vformat
  * ----------------------------------------------------------------------------
+ * The formatting core behind printf, vprintf, snprintf and vsnprintf. It
+ * writes the output of 'fmt' to 'sink' one character at a time, taking the
+ * arguments from 'argp' (pointing at the first variadic argument), and
+ * returns the number of characters produced.
+ *
  * A simplified printf-like function with limited support for:
  *   - %c  : character
  *   - %s  : string
@@ -130,14 +259,8 @@ int* printf_number(int* argp, int length, bool sign, int radix);
  * variadic arguments. This is non-portable but acceptable in certain low-level
  * contexts, especially older x86 environments.
  ******************************************************************************/
-void _cdecl printf(const char* fmt, ...)
+int vformat(FormatSink* sink, const char* fmt, int* argp)
 {
-    /* 
-     * We cast &fmt (address of the first parameter) to int*, then increment it
-     * to skip over 'fmt' itself. That gets us to the first variadic argument.
-     */
-    int* argp = (int*)&fmt;
-    
     /* State machine tracking:
      *   - state: current parser state (normal vs. length vs. spec).
      *   - length: length modifier (default, short, long, etc.).
@@ -149,9 +272,6 @@ void _cdecl printf(const char* fmt, ...)
     int radix = 10;
     bool sign = false;
 
-    /* Move 'argp' to point to the first variadic argument. */
-    argp++;
-
     /* Iterate over every character in the format string until we reach '\0'. */
     while (*fmt)
     {
@@ -172,7 +292,7 @@ void _cdecl printf(const char* fmt, ...)
 
                     /* Otherwise, it's just a normal character. Print it. */
                     default:    
-                        putc(*fmt);
+                        sink_putc(sink, *fmt);
                         break;
                 }
                 break;
@@ -247,7 +367,7 @@ void _cdecl printf(const char* fmt, ...)
                 {
                     /* %c: Print a single character. */
                     case 'c':   
-                        putc((char)*argp);
+                        sink_putc(sink, (char)*argp);
                         argp++;
                         break;
 
@@ -259,20 +379,20 @@ void _cdecl printf(const char* fmt, ...)
                         {
                             /* For 'far' strings, we skip 2 stack units. 
                              * This is environment-specific. */
-                            puts_f(*(const char far**)argp);
-                            argp += 2;
+                            sink_puts_f(sink, *(const char far**)argp);
+                            argp += PRINTF_ARG_SLOTS(const char far*);
                         }
                         else 
                         {
                             /* For normal strings, skip 1 stack unit. */
-                            puts(*(const char**)argp);
-                            argp++;
+                            sink_puts(sink, *(const char**)argp);
+                            argp += PRINTF_ARG_SLOTS(const char*);
                         }
                         break;
 
                     /* %%: Print literal '%'. */
                     case '%':   
-                        putc('%');
+                        sink_putc(sink, '%');
                         break;
 
                     /* %d or %i: Signed integer, decimal. */
@@ -280,14 +400,14 @@ void _cdecl printf(const char* fmt, ...)
                     case 'i':   
                         radix = 10; 
                         sign = true;
-                        argp = printf_number(argp, length, sign, radix);
+                        argp = printf_number(sink, argp, length, sign, radix);
                         break;
 
                     /* %u: Unsigned decimal. */
                     case 'u':   
                         radix = 10; 
                         sign = false;
-                        argp = printf_number(argp, length, sign, radix);
+                        argp = printf_number(sink, argp, length, sign, radix);
                         break;
 
                     /* %x, %X, or %p: Unsigned hex. 
@@ -297,14 +417,14 @@ void _cdecl printf(const char* fmt, ...)
                     case 'p':   
                         radix = 16; 
                         sign = false;
-                        argp = printf_number(argp, length, sign, radix);
+                        argp = printf_number(sink, argp, length, sign, radix);
                         break;
 
                     /* %o: Unsigned octal. */
                     case 'o':   
                         radix = 8;  
                         sign = false;
-                        argp = printf_number(argp, length, sign, radix);
+                        argp = printf_number(sink, argp, length, sign, radix);
                         break;
 
                     /* Any unknown specifier is ignored. */
@@ -324,6 +444,78 @@ void _cdecl printf(const char* fmt, ...)
         /* Move to the next character in the format string. */
         fmt++;
     }
+
+    return sink->Count;
+}
+
+/******************************************************************************
+ * stdio_sink_putc / memory_sink_putc
+ * ----------------------------------------------------------------------------
+ * Sink callbacks: stdout hands characters to putc (and so to the outputs
+ * chosen with stdio_SetOutputs); memory stores them in the sink's Buffer,
+ * keeping the last byte free for the terminating '\0'.
+ ******************************************************************************/
+static void stdio_sink_putc(FormatSink* sink, char c)
+{
+    (void)sink;
+    putc(c);
+}
+
+static void memory_sink_putc(FormatSink* sink, char c)
+{
+    if (sink->Count + 1 < sink->Size)
+        sink->Buffer[sink->Count] = c;
+}
+
+/******************************************************************************
+ * vprintf / printf
+ * ----------------------------------------------------------------------------
+ * Format to stdout. printf finds its arguments right after 'fmt': we take
+ * the address of 'fmt' and step over it.
+ ******************************************************************************/
+int vprintf(const char* fmt, int* args)
+{
+    FormatSink sink;
+
+    sink.PutChar = stdio_sink_putc;
+    sink.Buffer = NULL;
+    sink.Size = 0;
+    sink.Count = 0;
+    return vformat(&sink, fmt, args);
+}
+
+int _cdecl printf(const char* fmt, ...)
+{
+    return vprintf(fmt, (int*)&fmt + 1);
+}
+
+/******************************************************************************
+ * vsnprintf / snprintf
+ * ----------------------------------------------------------------------------
+ * Format into 'buffer', writing at most size - 1 characters plus a '\0'.
+ * Like their C library namesakes they return the full length of the
+ * output, which is >= size if it was cut short. Build a message once with
+ * these, then hand it to a device in a single write.
+ ******************************************************************************/
+int vsnprintf(char* buffer, uint16_t size, const char* fmt, int* args)
+{
+    FormatSink sink;
+
+    sink.PutChar = memory_sink_putc;
+    sink.Buffer = buffer;
+    sink.Size = size;
+    sink.Count = 0;
+    vformat(&sink, fmt, args);
+
+    if (size > 0)
+        buffer[(sink.Count < size) ? sink.Count : size - 1] = '\0';
+
+    return sink.Count;
+}
+
+int _cdecl snprintf(char* buffer, uint16_t size, const char* fmt, ...)
+{
+    return vsnprintf(buffer, size, fmt, (int*)&fmt + 1);
 }
 
 /******************************************************************************
@@ -334,6 +526,53 @@ void _cdecl printf(const char* fmt, ...)
  ******************************************************************************/
 const char g_HexChars[] = "0123456789abcdef";
 
+/******************************************************************************
+ * printf_digits_pow2
+ * ----------------------------------------------------------------------------
+ * Converts *number to digits of a power-of-two radix (2^bits, bits <= 4)
+ * into 'buffer', least significant digit first, and returns the digit
+ * count. The value is shifted right 'bits' at a time as four 16-bit words,
+ * so no 64-bit shift (a runtime library call in 16-bit code) is needed,
+ * and only the words that are still non-zero take part.
+ ******************************************************************************/
+static int printf_digits_pow2(unsigned long long* number, int bits, char* buffer)
+{
+    uint16_t* words = (uint16_t*)number;    /* Little-endian: [0] is lowest */
+    uint16_t mask = (1 << bits) - 1;
+    int top = 3;                            /* Highest non-zero word */
+    int pos = 0;
+    int i;
+
+    while (top > 0 && words[top] == 0)
+        top--;
+
+    /* Values that fit in 16 bits: plain shifts of one register. */
+    if (top == 0)
+    {
+        uint16_t value = words[0];
+        do
+        {
+            buffer[pos++] = g_HexChars[value & mask];
+            value >>= bits;
+        } while (value > 0);
+        return pos;
+    }
+
+    do
+    {
+        buffer[pos++] = g_HexChars[words[0] & mask];
+
+        for (i = 0; i < top; i++)
+            words[i] = (words[i] >> bits) | (words[i + 1] << (16 - bits));
+        words[top] >>= bits;
+
+        if (words[top] == 0 && top > 0)
+            top--;
+    } while (top > 0 || words[0] != 0);
+
+    return pos;
+}
+
 /******************************************************************************
  * printf_number
  * ----------------------------------------------------------------------------
@@ -343,6 +582,7 @@ const char g_HexChars[] = "0123456789abcdef";
  * specified 'radix' (base 10, 16, or 8). It then prints that string.
  *
  * Parameters:
+ *   - sink   : Where the digits go
  *   - argp   : Pointer to the current argument in the variadic list
  *   - length : Length modifier (default, short, long, etc.)
  *   - sign   : Indicates signed (true) or unsigned (false)
@@ -351,7 +591,7 @@ const char g_HexChars[] = "0123456789abcdef";
  * Returns:
  *   - Updated argp (moved past the consumed argument)
  ******************************************************************************/
-int* printf_number(int* argp, int length, bool sign, int radix)
+int* printf_number(FormatSink* sink, int* argp, int length, bool sign, int radix)
 {
     /* Temporary buffer for the string representation (in reverse). */
     char buffer[32];
@@ -416,7 +656,7 @@ int* printf_number(int* argp, int length, bool sign, int radix)
                 number = *(unsigned long int*)argp;
             }
             /* Move argp by 2 ints on the stack (ABI-specific). */
-            argp += 2;
+            argp += PRINTF_ARG_SLOTS(long int);
             break;
 
         /* 'll' -> might need 4 stack units for a 64-bit long long. */
@@ -436,28 +676,55 @@ int* printf_number(int* argp, int length, bool sign, int radix)
                 number = *(unsigned long long int*)argp;
             }
             /* Move argp by 4 ints on the stack (ABI-specific). */
-            argp += 4;
+            argp += PRINTF_ARG_SLOTS(long long int);
             break;
     }
 
     /**************************************************************************
-     * 2) Convert the numeric value to the desired base (radix).
-     *    We'll do this by repeated division, storing the remainder in
-     *    buffer[pos++] in reverse order (LS digit first).
+     * 2) Convert the numeric value to the desired base (radix), storing the
+     *    digits in buffer[pos++] in reverse order (LS digit first).
+     *    16-bit code has no cheap 64-bit arithmetic, so the conversion takes
+     *    the cheapest route the value allows:
+     *      - radix 16 and 8 peel digits off with shifts and masks,
+     *      - radix 10 divides with native 16-bit DIV once the value fits in
+     *        16 bits, a single 32-bit DIV (x86_div32_32) while it fits in
+     *        32 bits, and x86_div64_32 only while it really needs 64.
      **************************************************************************/
-    do 
+    if (radix == 16 || radix == 8)
     {
-        uint32_t rem;
+        pos = printf_digits_pow2(&number, radix == 16 ? 4 : 3, buffer);
+    }
+    else
+    {
+        uint32_t* halves = (uint32_t*)&number;   /* [0] = low, [1] = high */
+        uint32_t value32;
+        uint16_t value16;
+
+        while (halves[1] != 0)
+        {
+            uint32_t rem;
 
-        /* x86_div64_32(number, divisor, &result, &remainder)
-         * This is presumably a 64-bit / 32-bit division provided by x86.h 
-         * that updates 'number' with the quotient and 'rem' with the remainder. */
-        x86_div64_32(number, radix, &number, &rem);
+            /* x86_div64_32(number, divisor, &result, &remainder) */
+            x86_div64_32(number, radix, &number, &rem);
+            buffer[pos++] = g_HexChars[rem];
+        }
+
+        value32 = halves[0];
+        while (value32 > 0xFFFFul)
+        {
+            uint32_t rem;
 
-        /* Convert remainder (0 .. base-1) to a character. If base=16,
-         * 0->'0', 1->'1', ... 10->'a', etc. */
-        buffer[pos++] = g_HexChars[rem];
-    } while (number > 0);
+            x86_div32_32(value32, radix, &value32, &rem);
+            buffer[pos++] = g_HexChars[rem];
+        }
+
+        value16 = (uint16_t)value32;
+        do
+        {
+            buffer[pos++] = g_HexChars[value16 % radix];
+            value16 /= radix;
+        } while (value16 > 0);
+    }
 
     /**************************************************************************
      * 3) If this was a signed format and the original number was negative,
@@ -474,7 +741,7 @@ int* printf_number(int* argp, int length, bool sign, int radix)
      **************************************************************************/
     while (--pos >= 0)
     {
-        putc(buffer[pos]);
+        sink_putc(sink, buffer[pos]);
     }
 
     /* Return the updated argument pointer. */
@@ -1,6 +1,42 @@
 #pragma once
+#include "stdint.h"
 
+#define STDIO_OUTPUT_SCREEN 0x01
+#define STDIO_OUTPUT_SERIAL 0x02
+#define STDIO_OUTPUT_LOG    0x04
+
+#define STDIO_BUFFER_SIZE   128
+
+/* Outputs stage2 prints to. Mirrored to COM1 by default so headless runs
+ * (qemu -nographic -serial stdio) see everything, and always kept in the
+ * boot log. Build with -dSTDIO_DEFAULT_OUTPUTS=6 for serial only, or =4
+ * for a fast boot that only logs (the log is handed on to the kernel). */
+#ifndef STDIO_DEFAULT_OUTPUTS
+#define STDIO_DEFAULT_OUTPUTS (STDIO_OUTPUT_SCREEN | STDIO_OUTPUT_SERIAL | STDIO_OUTPUT_LOG)
+#endif
+
+#define NULL                ((void*)0)
+
+/* Destination of vformat's output. PutChar receives every character;
+ * Buffer and Size are for sinks that store them, Count is maintained by
+ * vformat. */
+typedef struct FormatSink
+{
+    void (*PutChar)(struct FormatSink* sink, char c);
+    char* Buffer;
+    uint16_t Size;
+    uint16_t Count;
+} FormatSink;
+
+void stdio_SetOutputs(uint8_t outputs);
+void flush();
 void putc(char c);
 void puts(const char* str);
 void puts_f(const char far* str);
-void _cdecl printf(const char* fmt, ...);
+
+/* 'args'/'argp' point at the first variadic argument on the stack. */
+int vformat(FormatSink* sink, const char* fmt, int* argp);
+int vprintf(const char* fmt, int* args);
+int _cdecl printf(const char* fmt, ...);
+int vsnprintf(char* buffer, uint16_t size, const char* fmt, int* args);
+int _cdecl snprintf(char* buffer, uint16_t size, const char* fmt, ...);
@@ -0,0 +1,59 @@
+/******************************************************************************
+ *  DESCRIPTION:
+ *      Stamps cstart_'s entry into the boot timeline (see timeline.h) and
+ *      prints the per-phase breakdown collected by all boot stages.
+ ******************************************************************************/
+
+#include "timeline.h"
+#include "stdio.h"
+#include "x86.h"
+
+/* 1 BIOS tick = 65536 / 1193182 s, i.e. 54.9 ms. A 16x16->32 MUL, since
+ * a 32-bit multiply in C needs a runtime library helper. */
+#define TICKS_TO_MS(ticks)          x86_mul16_16((ticks), 55)
+
+/******************************************************************************
+ * Timeline_StampCstart
+ * ----------------------------------------------------------------------------
+ * Records both clocks on entry to cstart_. Call it first thing.
+ ******************************************************************************/
+void Timeline_StampCstart()
+{
+    uint64_t tsc;
+
+    x86_ReadTsc(&tsc);
+    g_BootTimeline->CstartEntry = tsc;
+    g_BootTimeline->CstartTicks = *(const uint16_t far*)(uint32_t)0x046C;
+}
+
+/******************************************************************************
+ * print_phase
+ * ----------------------------------------------------------------------------
+ * Prints one timeline row for a phase measured in BIOS ticks. The counter
+ * words wrap, so the difference is taken modulo 2^16.
+ ******************************************************************************/
+static void print_phase(const char* name, uint16_t from, uint16_t to)
+{
+    uint16_t ticks = to - from;
+
+    printf("  %s %u ticks (%lu ms)\r\n", name, ticks, TICKS_TO_MS(ticks));
+}
+
+/******************************************************************************
+ * Timeline_Print
+ * ----------------------------------------------------------------------------
+ * Prints the boot timeline gathered so far. The kernel stamps its own entry
+ * after stage2 is gone, so it reports its row itself.
+ ******************************************************************************/
+void Timeline_Print()
+{
+    const BootTimeline far* tl = g_BootTimeline;
+
+    printf("Boot timeline:\r\n");
+    print_phase("stage1 entry  -> root dir read:", tl->Stage1Entry, tl->RootRead);
+    print_phase("root dir read -> FAT loaded:   ", tl->RootRead, tl->FatLoaded);
+    print_phase("FAT loaded    -> stage2 loaded:", tl->FatLoaded, tl->Stage2Loaded);
+    print_phase("stage2 loaded -> cstart_:      ", tl->Stage2Loaded, tl->CstartTicks);
+    print_phase("total to cstart_:              ", tl->Stage1Entry, tl->CstartTicks);
+    printf("  cstart_ entered at TSC %llu\r\n", tl->CstartEntry);
+}
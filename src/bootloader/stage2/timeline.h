@@ -0,0 +1,38 @@
+#pragma once
+#include "stdint.h"
+
+/******************************************************************************
+ * Boot timeline.
+ *
+ * Every boot stage stamps the moment it reaches a milestone into this block
+ * at 0000:0500 (free conventional memory that no stage loads over):
+ *   - stage1 and the stage2 entry stub record the low word of the BIOS tick
+ *     counter at 0040:006C (18.2 Hz, ~54.9 ms per tick),
+ *   - cstart_ and the kernel entry read the time stamp counter (RDTSC).
+ * cstart_ records both clocks, which ties the two halves together.
+ * Keep in sync with src/bootloader/stage1/boot.asm and src/kernel/main.asm.
+ ******************************************************************************/
+
+#define TIMELINE_ADDRESS            0x0500
+
+#pragma pack(push, 1)
+
+typedef struct
+{
+    uint16_t Stage1Entry;            // BIOS ticks: stage1 started
+    uint16_t RootRead;               // BIOS ticks: STAGE2.BIN found
+    uint16_t FatLoaded;              // BIOS ticks: last FAT sector read
+    uint16_t Stage2Loaded;           // BIOS ticks: stage2 entry reached
+    uint16_t CstartTicks;            // BIOS ticks: cstart_ entered
+    uint16_t _Reserved[3];
+
+    uint64_t CstartEntry;            // TSC: cstart_ entered
+    uint64_t KernelEntry;            // TSC: kernel entry reached
+} BootTimeline;
+
+#pragma pack(pop)
+
+#define g_BootTimeline              ((BootTimeline far*)(uint32_t)TIMELINE_ADDRESS)
+
+void Timeline_StampCstart();
+void Timeline_Print();
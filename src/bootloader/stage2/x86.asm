@@ -1,8 +1,24 @@
 ; *****************************************************************************
 ; DESCRIPTION:
-;   Contains two low-level routines for 16-bit x86 environments (small model):
+;   Contains low-level routines for 16-bit x86 environments (small model):
 ;     1) _x86_div64_32 - 64-bit / 32-bit division.
+;        _x86_div32_32 - 32-bit / 32-bit division (a single DIV).
+;        _x86_mul16_16 - 16-bit x 16-bit -> 32-bit multiplication.
+;        _x86_cmp64 - 64-bit unsigned compare.
+;        __U4M / __I4M / __U4D / __I4D - Watcom's 32-bit multiply and
+;        divide helpers, register-based (see below).
 ;     2) _x86_Video_WriteCharTeletype - Teletype-based character output via INT 10h.
+;     3) _x86_ReadTsc - Reads the time stamp counter (RDTSC, Pentium and later).
+;     4) _x86_Video_ScrollUp - Scrolls VGA text memory up one line (REP MOVSD).
+;     5) _x86_outb / _x86_inb - Port I/O.
+;     6) _memcpy / _memset / _memcmp - Far-pointer bulk memory (see memory.h).
+;     7) _x86_Disk_GetDriveParams / _x86_Disk_Reset / _x86_Disk_Read /
+;        _x86_Disk_ReadLba - BIOS disk services via INT 13h (see disk.c).
+;     8) _x86_EnterProtectedMode - Enters the loaded 32-bit kernel.
+;     9) _x86_A20_IsEnabled / _x86_A20_EnableFast /
+;        _x86_A20_EnableKeyboardController - The A20 gate.
+;        _x86_EnterUnrealMode / _x86_UnrealCopy - Flat 4 GiB copies from
+;        real mode ("unreal" or "big real" mode).
 ;
 ; ASSEMBLY MODE:
 ;   - bits 16: indicates 16-bit code. However, this code uses 32-bit registers
@@ -112,6 +128,181 @@ _x86_div64_32:
     pop bp              ; restore old BP
     ret                 ; return to caller
 
+; -----------------------------------------------------------------------------
+; void _cdecl x86_div32_32(uint32_t dividend, uint32_t divisor,
+;                          uint32_t* quotientOut, uint32_t* remainderOut);
+;
+;  One 32-bit DIV; used instead of x86_div64_32 once a value fits in 32
+;  bits (16-bit C code would otherwise call a runtime library helper).
+;
+;  Stack frame layout (small model, near call):
+;   [BP + 0]   = old BP
+;   [BP + 2]   = return IP
+;   [BP + 4]   = dividend                   (32-bit)
+;   [BP + 8]   = divisor                    (32-bit)
+;   [BP + 12]  = quotientOut pointer        (16-bit pointer in small model)
+;   [BP + 14]  = remainderOut pointer       (16-bit pointer in small model)
+; -----------------------------------------------------------------------------
+global _x86_div32_32
+_x86_div32_32:
+
+    ; Prologue: set up stack frame
+    push bp
+    mov bp, sp
+
+    push bx
+
+    mov eax, [bp + 4]   ; EAX = dividend
+    xor edx, edx
+    div dword [bp + 8]  ; EAX = quotient, EDX = remainder
+
+    mov bx, [bp + 12]
+    mov [bx], eax       ; *quotientOut
+    mov bx, [bp + 14]
+    mov [bx], edx       ; *remainderOut
+
+    ; Epilogue
+    pop bx
+    mov sp, bp
+    pop bp
+    ret
+
+; -----------------------------------------------------------------------------
+; int _cdecl x86_cmp64(uint64_t a, uint64_t b);
+;
+;  Unsigned compare; returns -1, 0 or 1 in AX as a < b, a == b, a > b.
+;  The high halves decide unless they are equal.
+;
+;  Stack frame layout (small model, near call):
+;   [BP + 0]   = old BP
+;   [BP + 2]   = return IP
+;   [BP + 4]   = lower 32 bits of a
+;   [BP + 8]   = upper 32 bits of a
+;   [BP + 12]  = lower 32 bits of b
+;   [BP + 16]  = upper 32 bits of b
+; -----------------------------------------------------------------------------
+global _x86_cmp64
+_x86_cmp64:
+
+    ; Prologue: set up stack frame
+    push bp
+    mov bp, sp
+
+    mov eax, [bp + 8]
+    cmp eax, [bp + 16]
+    jne .differ
+    mov eax, [bp + 4]
+    cmp eax, [bp + 12]
+    jne .differ
+
+    xor ax, ax          ; Equal
+    jmp .done
+
+.differ:
+    sbb ax, ax          ; CF set (a below b) -> -1, else 0
+    or ax, 1            ; -> -1 or 1
+
+.done:
+    ; Epilogue
+    mov sp, bp
+    pop bp
+    ret
+
+; -----------------------------------------------------------------------------
+; Watcom runtime helpers for 32-bit multiplication and division.
+;
+;  Stage2 is linked without Watcom's libraries (-zl), but wcc still calls
+;  these for every 32-bit '*', '/' and '%' in C code. They take their
+;  operands in registers rather than on the stack:
+;
+;   __U4M / __I4M: DX:AX = DX:AX * CX:BX (low 32 bits, so the same routine
+;                  serves signed and unsigned operands)
+;   __U4D / __I4D: DX:AX = DX:AX / CX:BX, CX:BX = DX:AX % CX:BX
+;                  (unsigned / signed, remainder has the dividend's sign)
+;
+;  Each does one 32-bit MUL or DIV instead of the 8086-compatible
+;  shift-and-add loops of the library versions.
+; -----------------------------------------------------------------------------
+global __U4M
+global __I4M
+__U4M:
+__I4M:
+    push cx
+
+    shl edx, 16
+    mov dx, ax
+    mov eax, edx        ; EAX = multiplicand
+    shl ecx, 16
+    mov cx, bx          ; ECX = multiplier
+    mul ecx
+
+    mov edx, eax
+    shr edx, 16         ; DX:AX = product
+
+    pop cx
+    ret
+
+global __U4D
+__U4D:
+    shl edx, 16
+    mov dx, ax
+    mov eax, edx        ; EAX = dividend
+    shl ecx, 16
+    mov cx, bx          ; ECX = divisor
+    xor edx, edx
+    div ecx
+
+    mov ebx, edx
+    mov ecx, edx
+    shr ecx, 16         ; CX:BX = remainder
+    mov edx, eax
+    shr edx, 16         ; DX:AX = quotient
+    ret
+
+global __I4D
+__I4D:
+    shl edx, 16
+    mov dx, ax
+    mov eax, edx        ; EAX = dividend
+    shl ecx, 16
+    mov cx, bx          ; ECX = divisor
+    cdq
+    idiv ecx
+
+    mov ebx, edx
+    mov ecx, edx
+    shr ecx, 16         ; CX:BX = remainder
+    mov edx, eax
+    shr edx, 16         ; DX:AX = quotient
+    ret
+
+; -----------------------------------------------------------------------------
+; uint32_t _cdecl x86_mul16_16(uint16_t a, uint16_t b);
+;
+;  One 16-bit MUL, returning the full 32-bit product in DX:AX. A 32-bit
+;  multiply written in C would call a runtime library helper instead.
+;
+;  Stack frame layout (small model, near call):
+;   [BP + 0] = old BP
+;   [BP + 2] = return IP
+;   [BP + 4] = a
+;   [BP + 6] = b
+; -----------------------------------------------------------------------------
+global _x86_mul16_16
+_x86_mul16_16:
+
+    ; Prologue: set up stack frame
+    push bp
+    mov bp, sp
+
+    mov ax, [bp + 4]
+    mul word [bp + 6]   ; DX:AX = a * b
+
+    ; Epilogue
+    mov sp, bp
+    pop bp
+    ret
+
 ; -----------------------------------------------------------------------------
 ; void _cdecl x86_Video_WriteCharTeletype(char character, int page);
 ;
@@ -152,3 +343,926 @@ _x86_Video_WriteCharTeletype:
     pop bp
     ret
 
+; -----------------------------------------------------------------------------
+; void _cdecl x86_ReadTsc(uint64_t* tscOut);
+;
+;  Stores the processor's time stamp counter in *tscOut. RDTSC needs a
+;  Pentium or later.
+;
+;  Stack frame layout (small model, near call):
+;   [BP + 0] = old BP
+;   [BP + 2] = return IP
+;   [BP + 4] = tscOut pointer (16-bit pointer in small model)
+; -----------------------------------------------------------------------------
+global _x86_ReadTsc
+_x86_ReadTsc:
+
+    ; Prologue: set up stack frame
+    push bp
+    mov bp, sp
+
+    push bx
+
+    rdtsc               ; EDX:EAX = time stamp counter
+
+    mov bx, [bp + 4]    ; BX = tscOut
+    mov [bx], eax       ; low 32 bits
+    mov [bx + 4], edx   ; high 32 bits
+
+    ; Epilogue
+    pop bx
+    mov sp, bp
+    pop bp
+    ret
+
+; -----------------------------------------------------------------------------
+; void _cdecl x86_Video_ScrollUp(uint16_t columns, uint16_t rows,
+;                                uint8_t attribute);
+;
+;  Scrolls the text screen at B800:0000 up by one line and blanks the bottom
+;  line with spaces in 'attribute'. Both the move and the fill are done a
+;  dword (two cells) at a time, so 'columns' must be even.
+;
+;  Stack frame layout (small model, near call):
+;   [BP + 0] = old BP
+;   [BP + 2] = return IP
+;   [BP + 4] = columns
+;   [BP + 6] = rows
+;   [BP + 8] = attribute (only 8 bits used, but stored as a 16-bit parameter)
+; -----------------------------------------------------------------------------
+global _x86_Video_ScrollUp
+_x86_Video_ScrollUp:
+
+    ; Prologue: set up stack frame
+    push bp
+    mov bp, sp
+
+    push bx
+    push si
+    push di
+    push ds
+    push es
+
+    mov ax, 0B800h      ; DS = ES = text memory (arguments are read via SS:BP)
+    mov ds, ax
+    mov es, ax
+    cld
+
+    ; Move lines 1 .. rows-1 to 0 .. rows-2.
+    mov bx, [bp + 4]    ; BX = columns
+    mov si, bx
+    shl si, 1           ; SI = start of line 1 (2 bytes per cell)
+    xor di, di          ; DI = start of line 0
+    mov cx, [bp + 6]
+    dec cx
+    imul cx, bx         ; CX = cells to move
+    shr cx, 1           ; Two cells per dword
+    rep movsd
+
+    ; Blank the last line; DI already points at it.
+    mov ah, [bp + 8]    ; AH = attribute
+    mov al, ' '
+    mov dx, ax
+    shl eax, 16
+    mov ax, dx          ; EAX = two blank cells
+    mov cx, bx
+    shr cx, 1
+    rep stosd
+
+    ; Epilogue
+    pop es
+    pop ds
+    pop di
+    pop si
+    pop bx
+    mov sp, bp
+    pop bp
+    ret
+
+; -----------------------------------------------------------------------------
+; void _cdecl x86_outb(uint16_t port, uint8_t value);
+;
+;  Writes 'value' to I/O port 'port'.
+;
+;  Stack frame layout (small model, near call):
+;   [BP + 0] = old BP
+;   [BP + 2] = return IP
+;   [BP + 4] = port
+;   [BP + 6] = value (only 8 bits used, but stored as a 16-bit parameter)
+; -----------------------------------------------------------------------------
+global _x86_outb
+_x86_outb:
+
+    ; Prologue: set up stack frame
+    push bp
+    mov bp, sp
+
+    mov dx, [bp + 4]    ; DX = port
+    mov al, [bp + 6]    ; AL = value
+    out dx, al
+
+    ; Epilogue
+    mov sp, bp
+    pop bp
+    ret
+
+; -----------------------------------------------------------------------------
+; uint8_t _cdecl x86_inb(uint16_t port);
+;
+;  Reads one byte from I/O port 'port' and returns it in AL.
+;
+;  Stack frame layout (small model, near call):
+;   [BP + 0] = old BP
+;   [BP + 2] = return IP
+;   [BP + 4] = port
+; -----------------------------------------------------------------------------
+global _x86_inb
+_x86_inb:
+
+    ; Prologue: set up stack frame
+    push bp
+    mov bp, sp
+
+    mov dx, [bp + 4]    ; DX = port
+    xor ax, ax
+    in al, dx           ; AL = value
+
+    ; Epilogue
+    mov sp, bp
+    pop bp
+    ret
+
+; -----------------------------------------------------------------------------
+; void far* _cdecl memcpy(void far* dst, const void far* src, uint16_t num);
+;
+;  Copies 'num' bytes and returns 'dst'. A few bytes are copied first to
+;  bring the destination to a dword boundary, then the bulk moves with
+;  REP MOVSD and the last 0..3 bytes with REP MOVSB. Neither block may
+;  cross the end of its segment, and they must not overlap.
+;
+;  Stack frame layout (small model, near call):
+;   [BP + 0]  = old BP
+;   [BP + 2]  = return IP
+;   [BP + 4]  = dst (offset, then segment)
+;   [BP + 8]  = src (offset, then segment)
+;   [BP + 12] = num
+; -----------------------------------------------------------------------------
+global _memcpy
+_memcpy:
+
+    ; Prologue: set up stack frame
+    push bp
+    mov bp, sp
+
+    push si
+    push di
+    push ds
+    push es
+
+    les di, [bp + 4]    ; ES:DI = dst
+    lds si, [bp + 8]    ; DS:SI = src (arguments are still read via SS:BP)
+    mov ax, [bp + 12]   ; AX = bytes left
+    cld
+
+    ; Head: CX = (-DI) & 3 bytes, but no more than 'num'.
+    mov cx, di
+    neg cx
+    and cx, 3
+    cmp cx, ax
+    jbe .head
+    mov cx, ax
+.head:
+    sub ax, cx
+    rep movsb
+
+    ; Body: whole dwords; tail: what is left over.
+    mov cx, ax
+    shr cx, 2
+    rep movsd
+    mov cx, ax
+    and cx, 3
+    rep movsb
+
+    mov ax, [bp + 4]    ; DX:AX = dst
+    mov dx, [bp + 6]
+
+    ; Epilogue
+    pop es
+    pop ds
+    pop di
+    pop si
+    mov sp, bp
+    pop bp
+    ret
+
+; -----------------------------------------------------------------------------
+; void far* _cdecl memset(void far* dst, int value, uint16_t num);
+;
+;  Fills 'num' bytes with the low byte of 'value' and returns 'dst'. Like
+;  memcpy: bytes up to a dword boundary, REP STOSD, then a byte tail.
+;
+;  Stack frame layout (small model, near call):
+;   [BP + 0]  = old BP
+;   [BP + 2]  = return IP
+;   [BP + 4]  = dst (offset, then segment)
+;   [BP + 8]  = value (only 8 bits used)
+;   [BP + 10] = num
+; -----------------------------------------------------------------------------
+global _memset
+_memset:
+
+    ; Prologue: set up stack frame
+    push bp
+    mov bp, sp
+
+    push di
+    push es
+
+    les di, [bp + 4]    ; ES:DI = dst
+    mov dx, [bp + 10]   ; DX = bytes left
+    cld
+
+    mov al, [bp + 8]    ; EAX = the byte, four times
+    mov ah, al
+    mov cx, ax
+    shl eax, 16
+    mov ax, cx
+
+    ; Head: CX = (-DI) & 3 bytes, but no more than 'num'.
+    mov cx, di
+    neg cx
+    and cx, 3
+    cmp cx, dx
+    jbe .head
+    mov cx, dx
+.head:
+    sub dx, cx
+    rep stosb
+
+    ; Body: whole dwords; tail: what is left over.
+    mov cx, dx
+    shr cx, 2
+    rep stosd
+    mov cx, dx
+    and cx, 3
+    rep stosb
+
+    mov ax, [bp + 4]    ; DX:AX = dst
+    mov dx, [bp + 6]
+
+    ; Epilogue
+    pop es
+    pop di
+    mov sp, bp
+    pop bp
+    ret
+
+; -----------------------------------------------------------------------------
+; int _cdecl memcmp(const void far* ptr1, const void far* ptr2, uint16_t num);
+;
+;  Compares 'num' bytes and returns 0 if they are equal, otherwise -1 or 1
+;  as the first differing byte (unsigned) is lower or higher in 'ptr1'.
+;  Dwords are compared with REPE CMPSD; the dword that differs, if any, is
+;  compared again byte by byte to find the first differing byte. Nothing is
+;  written, so there is no alignment head: misaligned reads only cost a
+;  cycle, while the typical use (32-byte directory entries) is aligned.
+;
+;  Stack frame layout (small model, near call):
+;   [BP + 0]  = old BP
+;   [BP + 2]  = return IP
+;   [BP + 4]  = ptr1 (offset, then segment)
+;   [BP + 8]  = ptr2 (offset, then segment)
+;   [BP + 12] = num
+; -----------------------------------------------------------------------------
+global _memcmp
+_memcmp:
+
+    ; Prologue: set up stack frame
+    push bp
+    mov bp, sp
+
+    push si
+    push di
+    push ds
+    push es
+
+    lds si, [bp + 4]    ; DS:SI = ptr1
+    les di, [bp + 8]    ; ES:DI = ptr2
+    mov dx, [bp + 12]
+    cld
+
+    mov cx, dx
+    shr cx, 2
+    jcxz .tail
+    repe cmpsd
+    je .tail
+
+    ; A dword differs: step back over it and find the byte.
+    sub si, 4
+    sub di, 4
+    mov cx, 4
+    jmp .bytes
+
+.tail:
+    mov cx, dx
+    and cx, 3
+
+.bytes:
+    xor ax, ax
+    jcxz .done
+    repe cmpsb
+    je .done
+    sbb ax, ax          ; CF set ([ptr1] below [ptr2]) -> -1, else 0
+    or ax, 1            ; -> -1 or 1
+
+.done:
+    ; Epilogue
+    pop es
+    pop ds
+    pop di
+    pop si
+    mov sp, bp
+    pop bp
+    ret
+
+; -----------------------------------------------------------------------------
+; bool _cdecl x86_Disk_GetDriveParams(uint8_t drive, uint8_t* driveTypeOut,
+;                                     uint16_t* cylindersOut,
+;                                     uint16_t* sectorsOut,
+;                                     uint16_t* headsOut);
+;
+;  INT 13h AH=08h. Returns false (CF set) if the BIOS does not know the
+;  drive. Cylinders and heads are returned as counts, not maximum values.
+;
+;  Stack frame layout (small model, near call):
+;   [BP + 0]  = old BP
+;   [BP + 2]  = return IP
+;   [BP + 4]  = drive (only 8 bits used)
+;   [BP + 6]  = driveTypeOut pointer
+;   [BP + 8]  = cylindersOut pointer
+;   [BP + 10] = sectorsOut pointer
+;   [BP + 12] = headsOut pointer
+; -----------------------------------------------------------------------------
+global _x86_Disk_GetDriveParams
+_x86_Disk_GetDriveParams:
+
+    ; Prologue: set up stack frame
+    push bp
+    mov bp, sp
+
+    push bx
+    push si
+    push di
+    push es
+
+    mov dl, [bp + 4]
+    mov ah, 08h
+    xor di, di          ; ES:DI = 0000:0000 works around buggy BIOSes
+    mov es, di
+    stc
+    int 13h
+
+    mov ax, 1
+    sbb ax, 0           ; AX = 1 on success, 0 if CF was set
+
+    mov si, [bp + 6]
+    mov [si], bl        ; *driveTypeOut
+
+    mov bl, ch          ; BX = cylinder bits 0..7 from CH, 8..9 from CL 6..7
+    mov bh, cl
+    shr bh, 6
+    inc bx
+    mov si, [bp + 8]
+    mov [si], bx        ; *cylindersOut
+
+    xor ch, ch
+    and cl, 3Fh
+    mov si, [bp + 10]
+    mov [si], cx        ; *sectorsOut
+
+    mov cl, dh
+    xor ch, ch
+    inc cx
+    mov si, [bp + 12]
+    mov [si], cx        ; *headsOut
+
+    ; Epilogue
+    pop es
+    pop di
+    pop si
+    pop bx
+    mov sp, bp
+    pop bp
+    ret
+
+; -----------------------------------------------------------------------------
+; bool _cdecl x86_Disk_Reset(uint8_t drive);
+;
+;  INT 13h AH=00h, used between read retries. Returns false on failure.
+;
+;  Stack frame layout (small model, near call):
+;   [BP + 0] = old BP
+;   [BP + 2] = return IP
+;   [BP + 4] = drive (only 8 bits used)
+; -----------------------------------------------------------------------------
+global _x86_Disk_Reset
+_x86_Disk_Reset:
+
+    ; Prologue: set up stack frame
+    push bp
+    mov bp, sp
+
+    mov dl, [bp + 4]
+    mov ah, 00h
+    stc
+    int 13h
+
+    mov ax, 1
+    sbb ax, 0           ; AX = 1 on success, 0 if CF was set
+
+    ; Epilogue
+    mov sp, bp
+    pop bp
+    ret
+
+; -----------------------------------------------------------------------------
+; bool _cdecl x86_Disk_Read(uint8_t drive, uint16_t cylinder, uint16_t sector,
+;                           uint16_t head, uint8_t count, void far* dataOut);
+;
+;  INT 13h AH=02h: reads 'count' sectors starting at the given CHS address
+;  (sector is 1-based) to 'dataOut'. The read must stay on one track and
+;  must not cross a 64 KiB boundary (disk.c takes care of both). Returns
+;  false on failure.
+;
+;  Stack frame layout (small model, near call):
+;   [BP + 0]  = old BP
+;   [BP + 2]  = return IP
+;   [BP + 4]  = drive (only 8 bits used)
+;   [BP + 6]  = cylinder (10 bits used)
+;   [BP + 8]  = sector (6 bits used)
+;   [BP + 10] = head (only 8 bits used)
+;   [BP + 12] = count (only 8 bits used)
+;   [BP + 14] = dataOut (offset, then segment)
+; -----------------------------------------------------------------------------
+global _x86_Disk_Read
+_x86_Disk_Read:
+
+    ; Prologue: set up stack frame
+    push bp
+    mov bp, sp
+
+    push bx
+    push es
+
+    mov dl, [bp + 4]    ; DL = drive
+    mov ch, [bp + 6]    ; CH = cylinder bits 0..7
+    mov cl, [bp + 7]
+    shl cl, 6           ; CL 6..7 = cylinder bits 8..9
+    mov al, [bp + 8]
+    and al, 3Fh
+    or cl, al           ; CL 0..5 = sector
+    mov dh, [bp + 10]   ; DH = head
+    mov al, [bp + 12]   ; AL = count
+    les bx, [bp + 14]   ; ES:BX = dataOut
+
+    mov ah, 02h
+    stc
+    int 13h
+
+    mov ax, 1
+    sbb ax, 0           ; AX = 1 on success, 0 if CF was set
+
+    ; Epilogue
+    pop es
+    pop bx
+    mov sp, bp
+    pop bp
+    ret
+
+; -----------------------------------------------------------------------------
+; bool _cdecl x86_Disk_ReadLba(uint8_t drive, uint32_t lba, uint16_t count,
+;                              void far* dataOut);
+;
+;  INT 13h AH=42h (extensions): reads 'count' sectors starting at 'lba' to
+;  'dataOut'. The disk address packet is built on the stack, so DS is
+;  pointed at SS for the call. The read must not cross a 64 KiB boundary
+;  (disk.c takes care of it). Returns false on failure.
+;
+;  Stack frame layout (small model, near call):
+;   [BP + 0]  = old BP
+;   [BP + 2]  = return IP
+;   [BP + 4]  = drive (only 8 bits used)
+;   [BP + 6]  = lba (32-bit)
+;   [BP + 10] = count
+;   [BP + 12] = dataOut (offset, then segment)
+; -----------------------------------------------------------------------------
+global _x86_Disk_ReadLba
+_x86_Disk_ReadLba:
+
+    ; Prologue: set up stack frame
+    push bp
+    mov bp, sp
+
+    push si
+    push ds
+
+    ; Disk address packet, pushed from the last field to the first.
+    push dword 0                ; LBA bits 32..63
+    push dword [bp + 6]         ; LBA bits 0..31
+    push dword [bp + 12]        ; Buffer (offset, then segment)
+    push word [bp + 10]         ; Sector count
+    push word 0010h             ; Packet size, reserved byte
+
+    mov ax, ss
+    mov ds, ax
+    mov si, sp          ; DS:SI = packet
+    mov dl, [bp + 4]
+    mov ah, 42h
+    stc
+    int 13h
+
+    mov ax, 1
+    sbb ax, 0           ; AX = 1 on success, 0 if CF was set
+    add sp, 16          ; Drop the packet
+
+    ; Epilogue
+    pop ds
+    pop si
+    mov sp, bp
+    pop bp
+    ret
+
+; -----------------------------------------------------------------------------
+; bool _cdecl x86_A20_IsEnabled();
+;
+;  Tests whether address line 20 is enabled: with A20 off, FFFF:7E0E
+;  (physical 107DFEh) wraps around to 0000:7DFE. A byte is written through
+;  one address and read back through the other; both bytes are restored.
+;
+;  Stack frame layout (small model, near call):
+;   [BP + 0] = old BP
+;   [BP + 2] = return IP
+; -----------------------------------------------------------------------------
+global _x86_A20_IsEnabled
+_x86_A20_IsEnabled:
+
+    ; Prologue: set up stack frame
+    push bp
+    mov bp, sp
+
+    push si
+    push di
+    push ds
+    push es
+
+    xor ax, ax
+    mov ds, ax          ; DS:SI = 0000:7DFE
+    mov si, 7DFEh
+    not ax
+    mov es, ax          ; ES:DI = FFFF:7E0E, 1 MiB higher
+    mov di, 7E0Eh
+
+    mov al, [es:di]
+    push ax
+    mov al, [ds:si]
+    push ax
+
+    mov byte [es:di], 00h
+    mov byte [ds:si], 0FFh
+    cmp byte [es:di], 0FFh  ; ZF set if the write wrapped around
+
+    pop ax
+    mov [ds:si], al
+    pop ax
+    mov [es:di], al
+
+    mov ax, 0
+    je .done            ; Wrapped: A20 is off
+    mov ax, 1
+
+.done:
+    ; Epilogue
+    pop es
+    pop ds
+    pop di
+    pop si
+    mov sp, bp
+    pop bp
+    ret
+
+; -----------------------------------------------------------------------------
+; void _cdecl x86_A20_EnableFast();
+;
+;  Sets the "fast A20" bit of system control port A (92h), leaving its
+;  reset bit (bit 0) clear. The caller verifies with x86_A20_IsEnabled.
+;
+;  Stack frame layout (small model, near call):
+;   [BP + 0] = old BP
+;   [BP + 2] = return IP
+; -----------------------------------------------------------------------------
+global _x86_A20_EnableFast
+_x86_A20_EnableFast:
+
+    ; Prologue: set up stack frame
+    push bp
+    mov bp, sp
+
+    in al, 92h
+    test al, 02h
+    jnz .done           ; Already on; do not touch the port
+    or al, 02h
+    and al, 0FEh
+    out 92h, al
+
+.done:
+    ; Epilogue
+    mov sp, bp
+    pop bp
+    ret
+
+; -----------------------------------------------------------------------------
+; void _cdecl x86_A20_EnableKeyboardController();
+;
+;  The classic way: sets the A20 bit in the 8042 keyboard controller's
+;  output port (read with command D0h, written back with D1h), with the
+;  keyboard disabled meanwhile. Every wait for the controller gives up
+;  after 65535 polls, so a machine without an 8042 does not hang. The
+;  caller verifies with x86_A20_IsEnabled.
+;
+;  Stack frame layout (small model, near call):
+;   [BP + 0] = old BP
+;   [BP + 2] = return IP
+; -----------------------------------------------------------------------------
+KBC_DATA_PORT           equ 60h
+KBC_COMMAND_PORT        equ 64h
+
+global _x86_A20_EnableKeyboardController
+_x86_A20_EnableKeyboardController:
+
+    ; Prologue: set up stack frame
+    push bp
+    mov bp, sp
+
+    pushf
+    cli
+
+    call kbc_wait_input
+    mov al, 0ADh        ; Disable the keyboard
+    out KBC_COMMAND_PORT, al
+
+    call kbc_wait_input
+    mov al, 0D0h        ; Read the output port
+    out KBC_COMMAND_PORT, al
+    call kbc_wait_output
+    in al, KBC_DATA_PORT
+    push ax
+
+    call kbc_wait_input
+    mov al, 0D1h        ; Write the output port
+    out KBC_COMMAND_PORT, al
+    call kbc_wait_input
+    pop ax
+    or al, 02h          ; A20 on
+    out KBC_DATA_PORT, al
+
+    call kbc_wait_input
+    mov al, 0AEh        ; Enable the keyboard
+    out KBC_COMMAND_PORT, al
+    call kbc_wait_input
+
+    ; Epilogue
+    popf
+    mov sp, bp
+    pop bp
+    ret
+
+; Waits until the 8042 can take a byte (input buffer empty).
+kbc_wait_input:
+    push cx
+    mov cx, 0FFFFh
+.poll:
+    in al, KBC_COMMAND_PORT
+    test al, 02h
+    jz .ready
+    loop .poll
+.ready:
+    pop cx
+    ret
+
+; Waits until the 8042 has a byte for us (output buffer full).
+kbc_wait_output:
+    push cx
+    mov cx, 0FFFFh
+.poll:
+    in al, KBC_COMMAND_PORT
+    test al, 01h
+    jnz .ready
+    loop .poll
+.ready:
+    pop cx
+    ret
+
+; -----------------------------------------------------------------------------
+; void _cdecl x86_EnterUnrealMode();
+;
+;  Switches to protected mode just long enough to load DS, ES, FS and GS
+;  with a flat 4 GiB data descriptor, then back to real mode and restores
+;  the segment values. The CPU keeps the 4 GiB limits it cached, so from
+;  then on 32-bit offsets reach all memory. A BIOS call may reload the
+;  segment registers with real-mode limits, so x86_UnrealCopy calls this
+;  again before every copy. Needs A20 enabled to be useful above 1 MiB.
+;
+;  Stack frame layout (small model, near call):
+;   [BP + 0] = old BP
+;   [BP + 2] = return IP
+; -----------------------------------------------------------------------------
+global _x86_EnterUnrealMode
+_x86_EnterUnrealMode:
+
+    ; Prologue: set up stack frame
+    push bp
+    mov bp, sp
+
+    push bx
+    push ds
+    push es
+    pushf
+    cli
+
+    call load_flat_gdt
+
+    mov eax, cr0
+    or al, 1            ; PE on
+    mov cr0, eax
+    jmp short .protected
+.protected:
+    mov bx, FLAT_DATA_SELECTOR
+    mov ds, bx
+    mov es, bx
+    mov fs, bx
+    mov gs, bx
+
+    and al, 0FEh        ; PE off
+    mov cr0, eax
+    jmp short .real
+.real:
+    xor ax, ax          ; FS = GS = 0, base 0, limits stay 4 GiB
+    mov fs, ax
+    mov gs, ax
+
+    ; Epilogue
+    popf
+    pop es
+    pop ds
+    pop bx
+    mov sp, bp
+    pop bp
+    ret
+
+; -----------------------------------------------------------------------------
+; Flat GDT, shared by unreal mode and the protected-mode handoff: a null
+; descriptor, then 32-bit code and data descriptors with base 0, limit
+; 4 GiB (4 KiB granularity), ring 0.
+; -----------------------------------------------------------------------------
+FLAT_CODE_SELECTOR      equ 08h
+FLAT_DATA_SELECTOR      equ 10h
+
+flat_gdt:
+    dq 0
+    dw 0FFFFh, 0000h                ; Code: limit 0..15, base 0..15
+    db 00h, 9Ah, 0CFh, 00h          ; base 16..23, present/exec/read, G+D, base 24..31
+    dw 0FFFFh, 0000h                ; Data
+    db 00h, 92h, 0CFh, 00h          ; present/read/write
+
+flat_gdt_descriptor:
+    dw flat_gdt_descriptor - flat_gdt - 1
+    dd 0                            ; Linear base, filled in at run time
+
+; Loads flat_gdt. LGDT takes a linear address, DS * 16 + offset, which is
+; only known at run time. Clobbers EAX.
+load_flat_gdt:
+    xor eax, eax
+    mov ax, ds
+    shl eax, 4
+    add eax, flat_gdt
+    mov [flat_gdt_descriptor + 2], eax
+    lgdt [flat_gdt_descriptor]
+    ret
+
+; -----------------------------------------------------------------------------
+; void _cdecl x86_EnterProtectedMode(uint32_t entry, uint32_t bootInfo);
+;
+;  Leaves stage2 for a 32-bit kernel: loads the flat GDT, sets CR0.PE and
+;  far-jumps into 32-bit code, which loads the flat data selector into all
+;  data segment registers, points ESP at PROTECTED_STACK_TOP and jumps to
+;  the physical address 'entry' with:
+;    EBX     = 'bootInfo' (physical address of the BootInfo)
+;    [ESP+4] = 'bootInfo' as well, so the entry can be a cdecl C function
+;  Interrupts stay disabled (there is no IDT yet). A20 must be enabled.
+;  Does not return.
+;
+;  Stack frame layout (small model, near call):
+;   [BP + 0] = old BP
+;   [BP + 2] = return IP
+;   [BP + 4] = entry    (32-bit physical address)
+;   [BP + 8] = bootInfo (32-bit physical address)
+; -----------------------------------------------------------------------------
+PROTECTED_STACK_TOP     equ 90000h  ; Below the boot log; stage2's disk cache is dead by now
+
+global _x86_EnterProtectedMode
+_x86_EnterProtectedMode:
+
+    push bp
+    mov bp, sp
+
+    cli
+    mov edi, [bp + 4]   ; EDI = entry
+    mov ebx, [bp + 8]   ; EBX = bootInfo
+
+    call load_flat_gdt
+
+    ; The far jump needs the linear address of protected_entry, too.
+    xor eax, eax
+    mov ax, ds
+    shl eax, 4
+    add eax, protected_entry
+    mov [protected_entry_pointer], eax
+
+    mov eax, cr0
+    or al, 1            ; PE on
+    mov cr0, eax
+    o32 jmp far [protected_entry_pointer]
+
+protected_entry_pointer:
+    dd 0                            ; Offset (linear), filled in at run time
+    dw FLAT_CODE_SELECTOR
+
+bits 32
+protected_entry:
+    mov ax, FLAT_DATA_SELECTOR
+    mov ds, ax
+    mov es, ax
+    mov fs, ax
+    mov gs, ax
+    mov ss, ax
+    mov esp, PROTECTED_STACK_TOP
+
+    push ebx            ; Argument
+    push 0              ; No return address
+    jmp edi
+bits 16
+
+; -----------------------------------------------------------------------------
+; void _cdecl x86_UnrealCopy(uint32_t destination, uint32_t source,
+;                            uint32_t count);
+;
+;  Copies 'count' bytes between two physical addresses anywhere in the
+;  4 GiB space with 32-bit REP MOVSD (then REP MOVSB for the last 0..3
+;  bytes), using DS = ES = 0 and 32-bit offsets. Enters unreal mode
+;  itself first, since any BIOS call since the last copy may have reset
+;  the cached 4 GiB limits. Requires A20 for addresses above 1 MiB.
+;
+;  Stack frame layout (small model, near call):
+;   [BP + 0]  = old BP
+;   [BP + 2]  = return IP
+;   [BP + 4]  = destination (32-bit physical address)
+;   [BP + 8]  = source      (32-bit physical address)
+;   [BP + 12] = count       (32-bit)
+; -----------------------------------------------------------------------------
+global _x86_UnrealCopy
+_x86_UnrealCopy:
+
+    ; Prologue: set up stack frame
+    push bp
+    mov bp, sp
+
+    push esi
+    push edi
+    push ds
+    push es
+
+    call _x86_EnterUnrealMode
+
+    xor ax, ax
+    mov ds, ax
+    mov es, ax
+    mov edi, [bp + 4]
+    mov esi, [bp + 8]
+    mov edx, [bp + 12]
+    cld
+
+    mov ecx, edx
+    shr ecx, 2
+    a32 rep movsd
+    mov ecx, edx
+    and ecx, 3
+    a32 rep movsb
+
+    ; Epilogue
+    pop es
+    pop ds
+    pop edi
+    pop esi
+    mov sp, bp
+    pop bp
+    ret
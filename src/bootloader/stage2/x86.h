@@ -2,5 +2,31 @@
 #include "stdint.h"
 
 void _cdecl x86_div64_32(uint64_t dividend, uint32_t divisor, uint64_t* quotientOut, uint32_t* remainderOut);
+void _cdecl x86_div32_32(uint32_t dividend, uint32_t divisor, uint32_t* quotientOut, uint32_t* remainderOut);
+uint32_t _cdecl x86_mul16_16(uint16_t a, uint16_t b);
+
+// 64-bit arithmetic that 16-bit C cannot do natively. 32-bit '*', '/' and
+// '%' need no helper here: x86.asm provides the runtime routines Watcom
+// calls for them (__U4M, __U4D, ...).
+int _cdecl x86_cmp64(uint64_t a, uint64_t b);
 
 void _cdecl x86_Video_WriteCharTeletype(char c, uint8_t page);
+void _cdecl x86_Video_ScrollUp(uint16_t columns, uint16_t rows, uint8_t attribute);
+
+void _cdecl x86_outb(uint16_t port, uint8_t value);
+uint8_t _cdecl x86_inb(uint16_t port);
+
+void _cdecl x86_ReadTsc(uint64_t* tscOut);
+
+bool _cdecl x86_Disk_GetDriveParams(uint8_t drive, uint8_t* driveTypeOut, uint16_t* cylindersOut, uint16_t* sectorsOut, uint16_t* headsOut);
+bool _cdecl x86_Disk_Reset(uint8_t drive);
+bool _cdecl x86_Disk_Read(uint8_t drive, uint16_t cylinder, uint16_t sector, uint16_t head, uint8_t count, void far* dataOut);
+bool _cdecl x86_Disk_ReadLba(uint8_t drive, uint32_t lba, uint16_t count, void far* dataOut);
+
+void _cdecl x86_EnterProtectedMode(uint32_t entry, uint32_t bootInfo);
+
+bool _cdecl x86_A20_IsEnabled();
+void _cdecl x86_A20_EnableFast();
+void _cdecl x86_A20_EnableKeyboardController();
+void _cdecl x86_EnterUnrealMode();
+void _cdecl x86_UnrealCopy(uint32_t destination, uint32_t source, uint32_t count);
@@ -1,60 +1,250 @@
 ; =============================================================================
-; Minimal 16-bit Real Mode Program
-; Prints a message to the screen and then halts forever.
+; Minimal 32-bit Protected Mode Kernel
+; Stamps its entry into the boot timeline, prints a message, the time since
+; stage2's cstart_ and where stage2 left its boot info to the screen and
+; COM1, and then halts forever.
+;
+; Stage2 loads this file at 1 MiB and jumps to its first byte in 32-bit
+; protected mode with flat 4 GiB segments, interrupts disabled, and EBX
+; pointing at the KernelBootInfo (src/bootloader/stage2/pmode.h). There is no
+; BIOS any more: the screen is VGA text memory at 0B8000h and COM1 is the
+; 16550 stage2 already initialised.
 ; =============================================================================
 
-org 0x0000            ; Assemble assuming we load at linear address 0x0000.
-bits 16               ; 16-bit code.
+org 0x100000          ; Loaded at linear address 1 MiB.
+bits 32               ; 32-bit code.
 
-%define ENDL 0x0D, 0x0A  ; DOS/BIOS newline sequence: CR LF
+%define ENDL 0x0D, 0x0A  ; Newline sequence: CR LF
+
+; Boot timeline at 0000:0500 (see src/bootloader/stage2/timeline.h).
+TL_CSTART_ENTRY     equ 0510h   ; TSC when stage2's cstart_ was entered
+TL_KERNEL_ENTRY     equ 0518h   ; TSC when we got here
+
+; Text screen, and the cursor position stage2 left in the BIOS data area.
+VGA_TEXT            equ 0B8000h
+VGA_COLUMNS         equ 80
+VGA_ROWS            equ 25
+VGA_ATTRIBUTE       equ 07h
+BDA_CURSOR_COLUMN   equ 0450h
+BDA_CURSOR_ROW      equ 0451h
+
+; KernelBootInfo, at the physical address stage2 passes in EBX. Fixed
+; offsets, all fields 32 bits; stage2 only ever appends fields, and BI_SIZE
+; says how many there are. Keep in sync with src/bootloader/stage2/pmode.h.
+BI_MAGIC            equ 0       ; BOOT_INFO_MAGIC ('DUCK')
+BI_SIZE             equ 4       ; Size of the structure in bytes
+BI_BOOT_DRIVE       equ 8       ; BIOS drive number
+BI_PARTITION_OFFSET equ 12      ; LBA of the boot partition
+BI_BOOT_LOG         equ 16      ; Physical address of stage2's boot log
+BI_KERNEL_ADDRESS   equ 20      ; Physical address we were loaded to
+BI_KERNEL_SIZE      equ 24      ; Size of KERNEL.BIN in bytes
+BOOT_INFO_MAGIC     equ 4B435544h
+
+; Header of stage2's boot log. Keep in sync with
+; src/bootloader/stage2/bootlog.h.
+BL_MAGIC            equ 0       ; BOOT_LOG_MAGIC ('BLOG')
+BL_WRITTEN          equ 8       ; Total bytes stage2 logged
+BOOT_LOG_MAGIC      equ 474F4C42h
+
+COM1_PORT           equ 03F8h
+COM1_LINE_STATUS    equ COM1_PORT + 5
+LSR_THRE            equ 20h
 
 ; -----------------------------------------------------------------------------
 ; start:
-;   Main entry point. It loads DS:SI with the address of our string and then
-;   calls the "puts" routine. After printing, it disables interrupts and halts
-;   the CPU.
+;   Main entry point. Prints the greeting, the cycle count since cstart_,
+;   the boot info address and, if EBX points at a KernelBootInfo, the
+;   kernel size from it and how much stage2 wrote to its boot log, then
+;   disables interrupts and halts the CPU.
 ; -----------------------------------------------------------------------------
 start:
-    mov si, msg_hello   ; DS:SI -> the string we want to print
+    ; Stamp our arrival in the boot timeline before doing anything else.
+    rdtsc                               ; EDX:EAX = time stamp counter
+    mov [TL_KERNEL_ENTRY], eax
+    mov [TL_KERNEL_ENTRY + 4], edx
+    sub eax, [TL_CSTART_ENTRY]          ; EAX = cycles since cstart_ (low 32 bits)
+    mov ebp, eax
+
+    ; Continue on the screen where stage2 stopped.
+    movzx eax, byte [BDA_CURSOR_ROW]
+    imul eax, VGA_COLUMNS
+    movzx ecx, byte [BDA_CURSOR_COLUMN]
+    add eax, ecx
+    mov [cursor], eax
+
+    mov esi, msg_hello  ; ESI -> the string we want to print
     call puts           ; Print the string
 
+    mov esi, msg_timeline
+    call puts
+    mov eax, ebp
+    call put_hex32      ; Print EAX
+    mov esi, msg_cycles
+    call puts
+
+    ; EBX = physical address of the KernelBootInfo (offsets: BI_* above).
+    mov esi, msg_boot_info
+    call puts
+    mov eax, ebx
+    call put_hex32
+    mov esi, msg_newline
+    call puts
+
+    cmp dword [ebx + BI_MAGIC], BOOT_INFO_MAGIC
+    jne .halt
+    mov esi, msg_kernel_size
+    call puts
+    mov eax, [ebx + BI_KERNEL_SIZE]
+    call put_hex32
+    mov esi, msg_newline
+    call puts
+
+    mov edi, [ebx + BI_BOOT_LOG]
+    cmp dword [edi + BL_MAGIC], BOOT_LOG_MAGIC
+    jne .halt
+    mov esi, msg_boot_log
+    call puts
+    mov eax, [edi + BL_WRITTEN]
+    call put_hex32
+    mov esi, msg_bytes
+    call puts
+
 .halt:
     cli                 ; Disable interrupts
     hlt                 ; Halt the CPU (it will stay here forever)
+    jmp .halt
 
 ; -----------------------------------------------------------------------------
 ; puts:
-;   Prints a null-terminated string pointed to by DS:SI in 16-bit real mode
-;   using BIOS interrupt 0x10, AH=0x0E (teletype output).
+;   Prints a null-terminated string pointed to by ESI using putc.
 ; -----------------------------------------------------------------------------
 puts:
     ; Save registers that we'll modify in the function
-    push si
-    push ax
-    push bx
+    push esi
+    push eax
 
 .loop:
-    lodsb               ; AL = [DS:SI], SI++
+    lodsb               ; AL = [ESI], ESI++
     or al, al           ; Check if AL == 0 (null terminator)
     jz .done
 
-    mov ah, 0x0E        ; BIOS Teletype function
-    mov bh, 0           ; Display page = 0
-    int 0x10            ; Print character in AL
+    call putc           ; Print character in AL
 
     jmp .loop
 
 .done:
-    pop bx
-    pop ax
-    pop si
+    pop eax
+    pop esi
     ret
 
 ; -----------------------------------------------------------------------------
-; Our message (null-terminated). We add a DOS/BIOS newline (CR, LF) before the 0.
+; put_hex32:
+;   Prints EAX as 8 hexadecimal digits using putc.
 ; -----------------------------------------------------------------------------
-msg_hello: db 'hello from the kernel fellow duck', ENDL, 0
+put_hex32:
+    push eax
+    push ecx
+    push edx
+
+    mov ecx, 8          ; 8 nibbles, most significant first
+.next_digit:
+    rol eax, 4          ; Bring the next nibble into AL's low bits
+    mov edx, eax
+    and al, 0x0F
+    add al, '0'
+    cmp al, '9'
+    jbe .print
+    add al, 'A' - '9' - 1
+.print:
+    call putc
+    mov eax, edx        ; Restore the rotated value
+    loop .next_digit
+
+    pop edx
+    pop ecx
+    pop eax
+    ret
+
+; -----------------------------------------------------------------------------
+; putc:
+;   Prints the character in AL to VGA text memory at the cursor (CR and LF
+;   move it, the screen scrolls at the bottom) and to COM1 once the UART's
+;   transmit holding register is empty.
+; -----------------------------------------------------------------------------
+putc:
+    push eax
+    push ecx
+    push edx
+    push esi
+    push edi
+
+    ; Serial first: AL is still the character.
+    mov ah, al
+    mov dx, COM1_LINE_STATUS
+.wait_serial:
+    in al, dx
+    test al, LSR_THRE
+    jz .wait_serial
+    mov al, ah
+    mov dx, COM1_PORT
+    out dx, al
+
+    ; Screen.
+    mov eax, [cursor]
+    cmp byte [esp + 16], 0x0D   ; The saved AL: the character
+    jne .not_cr
+    xor edx, edx        ; Back to the start of the line
+    mov ecx, VGA_COLUMNS
+    div ecx
+    imul eax, VGA_COLUMNS
+    jmp .moved
+.not_cr:
+    cmp byte [esp + 16], 0x0A
+    jne .not_lf
+    add eax, VGA_COLUMNS
+    jmp .moved
+.not_lf:
+    mov cl, [esp + 16]
+    mov ch, VGA_ATTRIBUTE
+    mov [VGA_TEXT + eax * 2], cx
+    inc eax
+
+.moved:
+    cmp eax, VGA_COLUMNS * VGA_ROWS
+    jb .store
+    ; Scroll up one line and blank the last one.
+    mov esi, VGA_TEXT + VGA_COLUMNS * 2
+    mov edi, VGA_TEXT
+    mov ecx, VGA_COLUMNS * (VGA_ROWS - 1) / 2
+    cld
+    rep movsd
+    mov eax, (VGA_ATTRIBUTE << 24) | (' ' << 16) | (VGA_ATTRIBUTE << 8) | ' '
+    mov ecx, VGA_COLUMNS / 2
+    rep stosd
+    mov eax, VGA_COLUMNS * (VGA_ROWS - 1)
+.store:
+    mov [cursor], eax
+
+    pop edi
+    pop esi
+    pop edx
+    pop ecx
+    pop eax
+    ret
+
+cursor: dd 0            ; Cell index of the next character
+
+; -----------------------------------------------------------------------------
+; Our messages (null-terminated). We add a newline (CR, LF) before the 0.
+; -----------------------------------------------------------------------------
+msg_hello: db 'hello from the 32-bit kernel fellow duck', ENDL, 0
+msg_timeline: db 'Boot timeline: cstart_ -> kernel entry: 0x', 0
+msg_cycles: db ' cycles', ENDL, 0
+msg_boot_info: db 'Boot info at 0x', 0
+msg_kernel_size: db 'Kernel size: 0x', 0
+msg_boot_log: db 'Boot log: 0x', 0
+msg_bytes: db ' bytes', ENDL, 0
+msg_newline: db ENDL, 0
 
 ; No more code. When the CPU reaches .halt, it stops forever.
 ; =============================================================================
-
@@ -0,0 +1,264 @@
+/******************************************************************************
+ * Host Test and Benchmark for Stage2's stdio.c
+ *
+ * Usage:
+ *   make test_stdio
+ *
+ * Description:
+ *   - stdio.c is compiled with the host gcc (see the Makefile target), with
+ *     'far' and '_cdecl' defined away and its public names prefixed with
+ *     stage2_ so they do not clash with the C library.
+ *   - The device, profiler and x86 routines stdio.c calls (console, serial,
+ *     boot log, Profile_Begin/End, x86_div64_32, x86_div32_32) are mocked
+ *     below; the console mock captures what printf would have put on screen.
+ *   - Every specifier used by cstart_'s test strings is checked through
+ *     both printf (vprintf) and snprintf (vsnprintf).
+ *   - Finally the same strings are formatted over and over to report
+ *     formatted characters per second.
+ *
+ * printf walks its arguments in 'int' stack units, as laid out by the
+ * 16-bit caller. The tests build that layout themselves (ArgList), since a
+ * 64-bit host passes variadic arguments differently.
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* ------------------------------------------------------------------------- */
+/* Stage2 stdio.c, as built by the test_stdio Makefile target                */
+/* ------------------------------------------------------------------------- */
+
+#define STDIO_OUTPUT_SCREEN 0x01
+
+int stage2_vprintf(const char* fmt, int* args);
+int stage2_vsnprintf(char* buffer, uint16_t size, const char* fmt, int* args);
+void stage2_flush(void);
+void stdio_SetOutputs(uint8_t outputs);
+
+/* ------------------------------------------------------------------------- */
+/* Mocks                                                                     */
+/* ------------------------------------------------------------------------- */
+
+static char g_Screen[1024];
+static size_t g_ScreenLength;
+
+void Console_Write(const char* str, uint16_t length)
+{
+    if (g_ScreenLength + length < sizeof(g_Screen))
+    {
+        memcpy(g_Screen + g_ScreenLength, str, length);
+        g_ScreenLength += length;
+    }
+}
+
+void Console_Flush(void) {}
+void Serial_Init(uint16_t port, uint16_t divisor) {}
+void Serial_Write(uint16_t port, const char* data, uint16_t length) {}
+void BootLog_Write(const char* data, uint16_t length) {}
+void Profile_Begin(const char* name) {}
+void Profile_End(const char* name) {}
+
+void x86_div64_32(uint64_t dividend, uint32_t divisor, uint64_t* quotientOut, uint32_t* remainderOut)
+{
+    *remainderOut = (uint32_t)(dividend % divisor);
+    *quotientOut = dividend / divisor;
+}
+
+void x86_div32_32(uint32_t dividend, uint32_t divisor, uint32_t* quotientOut, uint32_t* remainderOut)
+{
+    *remainderOut = dividend % divisor;
+    *quotientOut = dividend / divisor;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Argument lists in stage2's layout                                         */
+/* ------------------------------------------------------------------------- */
+
+typedef struct
+{
+    int Slots[32];
+    size_t Count;
+} ArgList;
+
+/* Append 'size' bytes, rounded up to whole 'int' units like printf expects. */
+static void arg_push(ArgList* args, const void* value, size_t size)
+{
+    memcpy(&args->Slots[args->Count], value, size);
+    args->Count += (size + sizeof(int) - 1) / sizeof(int);
+}
+
+#define ARG(args, type, value)  do { type v_ = (value); arg_push(args, &v_, sizeof(v_)); } while (0)
+
+/* ------------------------------------------------------------------------- */
+/* Test cases: cstart_'s test strings                                        */
+/* ------------------------------------------------------------------------- */
+
+typedef struct
+{
+    const char* Format;
+    const char* Expected;
+    ArgList Args;
+} TestCase;
+
+static TestCase g_Tests[8];
+static int g_TestCount;
+
+static TestCase* add_test(const char* format, const char* expected)
+{
+    TestCase* test = &g_Tests[g_TestCount++];
+    test->Format = format;
+    test->Expected = expected;
+    test->Args.Count = 0;
+    return test;
+}
+
+static void build_tests(void)
+{
+    TestCase* t;
+
+    t = add_test("Formatted %% %c %s %ls\r\n", "Formatted % a string far string\r\n");
+    ARG(&t->Args, int, 'a');
+    ARG(&t->Args, const char*, "string");
+    ARG(&t->Args, const char*, "far string");
+
+    t = add_test("Formatted %d %i %x %p %o %hd %hi %hhu %hhd\r\n",
+                 "Formatted 1234 -5678 dead beef 12345 27 -42 20 -10\r\n");
+    ARG(&t->Args, int, 1234);
+    ARG(&t->Args, int, -5678);
+    ARG(&t->Args, int, 0xdead);
+    ARG(&t->Args, int, 0xbeef);
+    ARG(&t->Args, int, 012345);
+    ARG(&t->Args, int, (short)27);
+    ARG(&t->Args, int, (short)-42);
+    ARG(&t->Args, int, (unsigned char)20);
+    ARG(&t->Args, int, (signed char)-10);
+
+    t = add_test("Formatted %ld %lx %lld %llx\r\n",
+                 "Formatted -100000000 deadbeef 10200300400 deadbeeffeebdaed\r\n");
+    ARG(&t->Args, long, -100000000l);
+    ARG(&t->Args, unsigned long, 0xdeadbeeful);
+    ARG(&t->Args, long long, 10200300400ll);
+    ARG(&t->Args, unsigned long long, 0xdeadbeeffeebdaedull);
+
+    t = add_test("Formatted %s %u %lx %c", "Formatted into memory 65535 cafebabe !");
+    ARG(&t->Args, const char*, "into memory");
+    ARG(&t->Args, unsigned int, 65535u);
+    ARG(&t->Args, unsigned long, 0xcafebabeul);
+    ARG(&t->Args, int, '!');
+
+    t = add_test("Boot drive %x, %u heads, %lu, %llu\r\n", "Boot drive 80, 16 heads, 2048, 18446744073709551615\r\n");
+    ARG(&t->Args, int, 0x80);
+    ARG(&t->Args, unsigned int, 16);
+    ARG(&t->Args, unsigned long, 2048ul);
+    ARG(&t->Args, unsigned long long, 0xffffffffffffffffull);
+
+    t = add_test("%d %x %o %llo %lld", "0 0 0 1777777777777777777777 -9223372036854775807");
+    ARG(&t->Args, int, 0);
+    ARG(&t->Args, int, 0);
+    ARG(&t->Args, int, 0);
+    ARG(&t->Args, unsigned long long, 0xffffffffffffffffull);
+    ARG(&t->Args, long long, -9223372036854775807ll);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Checks                                                                    */
+/* ------------------------------------------------------------------------- */
+
+static int check(const char* how, const TestCase* test, const char* actual)
+{
+    if (strcmp(actual, test->Expected) == 0)
+        return 0;
+
+    fprintf(stderr, "FAIL (%s) \"%s\"\n  expected \"%s\"\n  got      \"%s\"\n",
+            how, test->Format, test->Expected, actual);
+    return 1;
+}
+
+static int run_tests(void)
+{
+    int failures = 0;
+    int i;
+
+    for (i = 0; i < g_TestCount; i++)
+    {
+        TestCase* test = &g_Tests[i];
+        char buffer[128];
+        int length;
+
+        /* printf -> putc -> flush -> Console_Write */
+        g_ScreenLength = 0;
+        stage2_vprintf(test->Format, test->Args.Slots);
+        stage2_flush();
+        g_Screen[g_ScreenLength] = '\0';
+        failures += check("printf", test, g_Screen);
+
+        /* snprintf into a large enough buffer */
+        length = stage2_vsnprintf(buffer, sizeof(buffer), test->Format, test->Args.Slots);
+        failures += check("snprintf", test, buffer);
+        if (length != (int)strlen(test->Expected))
+        {
+            fprintf(stderr, "FAIL (snprintf length) \"%s\": %d\n", test->Format, length);
+            failures++;
+        }
+
+        /* snprintf cut short: terminated, still reports the full length */
+        length = stage2_vsnprintf(buffer, 8, test->Format, test->Args.Slots);
+        if (length != (int)strlen(test->Expected) || strlen(buffer) != 7
+            || strncmp(buffer, test->Expected, 7) != 0)
+        {
+            fprintf(stderr, "FAIL (snprintf truncated) \"%s\": \"%s\" %d\n", test->Format, buffer, length);
+            failures++;
+        }
+    }
+
+    return failures;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Benchmark                                                                 */
+/* ------------------------------------------------------------------------- */
+
+#define BENCHMARK_ROUNDS 200000
+
+static void run_benchmark(void)
+{
+    struct timespec start, end;
+    unsigned long long characters = 0;
+    double seconds;
+    char buffer[128];
+    int round, i;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (round = 0; round < BENCHMARK_ROUNDS; round++)
+    {
+        for (i = 0; i < g_TestCount; i++)
+            characters += stage2_vsnprintf(buffer, sizeof(buffer), g_Tests[i].Format, g_Tests[i].Args.Slots);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("stdio benchmark: %llu characters in %.3f s, %.0f characters/s\n",
+           characters, seconds, characters / seconds);
+}
+
+int main(void)
+{
+    int failures;
+
+    stdio_SetOutputs(STDIO_OUTPUT_SCREEN);
+    build_tests();
+
+    failures = run_tests();
+    if (failures > 0)
+    {
+        fprintf(stderr, "stdio tests: %d failure(s)\n", failures);
+        return 1;
+    }
+    printf("stdio tests: %d format strings OK\n", g_TestCount);
+
+    run_benchmark();
+    return 0;
+}